@@ -2,14 +2,22 @@
 #define BASE_ALLOCATOR_HPP
 
 #include <vector>
+#include <list>
+#include <map>
+#include <unordered_map>
 #include <memory>
 #include "common/types.hpp"
 
 using namespace std;
 
+// Blocks are kept in physical (address) order; each node's prev/next are
+// its physical neighbors, and iterators stay valid across split and merge.
+using BlockList = list<MemoryBlock>;
+using BlockIterator = BlockList::iterator;
+
 class BaseAllocator {
 protected:
-    vector<MemoryBlock> memory_blocks_;
+    BlockList memory_blocks_;
     Size total_memory_;
     BlockId next_block_id_;
     MemoryStats stats_;
@@ -18,6 +26,40 @@ protected:
     size_t allocation_failures_;
     Size internal_fragmentation_;
 
+    // Blocks (or index nodes) examined by findFreeBlock, for comparing
+    // search cost across strategies.
+    size_t blocks_scanned_;
+    size_t longest_scan_;
+
+    // Resize outcomes: grown or shrunk where it stood, or moved (with the
+    // old contents copied to the new block).
+    size_t realloc_in_place_;
+    size_t realloc_moved_;
+    Size realloc_bytes_copied_;
+
+    // Aligned requests served, and the bytes of leading padding split off
+    // in front of them (left behind as small free blocks).
+    size_t aligned_allocations_;
+    Size alignment_waste_;
+
+    // Everything below this address is already packed (no free blocks), so
+    // a compaction step resumes here instead of at address 0.
+    Address compact_cursor_;
+
+    // Free blocks ordered by (size, start address), kept in sync with
+    // memory_blocks_ so size-driven fits are a single ordered lookup.
+    map<pair<Size, Address>, BlockIterator> free_by_size_;
+
+    // Total size of the blocks in free_by_size_, kept by the index hooks so
+    // getStats never walks the block list.
+    Size free_bytes_;
+
+    // Every block (free or allocated) by id and by start address.
+    unordered_map<BlockId, BlockIterator> block_index_;
+    map<Address, BlockIterator> address_index_;
+
+    // Set while metadata tracing is on; see setMetadataObserver.
+    MetadataObserver metadata_observer_;
 
 public:
     BaseAllocator(Size total_memory);
@@ -28,26 +70,108 @@ public:
     virtual AllocationResult allocate(const AllocationRequest& request) = 0;
 
     virtual bool deallocate(BlockId block_id);
+    virtual bool deallocateAddress(Address address, ProcessId process_id);
+
+    // Batch entry points for trace replay. Results come back in request
+    // order; a batch free merges each run of adjacent free blocks once.
+    virtual vector<AllocationResult> allocateBatch(const vector<Size>& sizes, ProcessId process_id);
+    virtual size_t deallocateBatch(const vector<Address>& addresses, ProcessId process_id);
+
+    // Resizes a live block, in place when the block can grow into free
+    // space right after it (or shrink), otherwise by allocate, copy, free.
+    // On failure the old block is left untouched.
+    virtual AllocationResult reallocate(Address address, Size new_size, ProcessId process_id);
+
+    // Requested size of the live block at address, or 0 if it is not one
+    // of process_id's allocations.
+    virtual Size allocationSize(Address address, ProcessId process_id) const;
 
     virtual MemoryStats getStats() const;
 
-    virtual const vector<MemoryBlock>& getBlocks() const;
+    virtual const BlockList& getBlocks() const;
+
+    // Approximate heap footprint of the allocator's own bookkeeping.
+    virtual size_t getMetadataBytes() const;
 
     virtual void coalesce();
 
-    virtual vector<MemoryBlock>::iterator findFreeBlock(Size size) = 0;
+    // Slides allocated blocks toward address 0, moving at most max_bytes
+    // (always at least one block) and appending one Relocation per move.
+    // Returns the bytes moved; 0 means nothing more can move. Aligned
+    // blocks are only moved to addresses that keep their alignment.
+    virtual Size compactStep(Size max_bytes, vector<Relocation>& relocations);
 
-    virtual bool splitBlock(vector<MemoryBlock>::iterator block_it, Size requested_size);
+    virtual BlockIterator findFreeBlock(Size size) = 0;
 
-    virtual void mergeBlocks(vector<MemoryBlock>::iterator first,
-                             vector<MemoryBlock>::iterator second);
+    virtual bool splitBlock(BlockIterator block_it, Size requested_size);
+
+    virtual void mergeBlocks(BlockIterator first, BlockIterator second);
 
     Size getTotalMemory() const { return total_memory_; }
     bool isInitialized() const { return !memory_blocks_.empty(); }
 
+    // Reports every metadata read and write the allocator would do on real
+    // memory. Block headers sit in the first HEADER_BYTES of each block and
+    // free-list links right after them; out-of-band structures (trees,
+    // bins, bitmaps) live in a region starting at total_memory_. An empty
+    // observer turns tracing off.
+    virtual void setMetadataObserver(MetadataObserver observer);
+
+    static constexpr Size HEADER_BYTES = 8;
+
 protected:
-    vector<MemoryBlock>::iterator findBlockById(BlockId id);
-    vector<MemoryBlock>::const_iterator findBlockById(BlockId id) const;
+    BlockIterator findBlockById(BlockId id);
+    BlockList::const_iterator findBlockById(BlockId id) const;
+    BlockIterator findBlockByAddress(Address address);
+
+    void markAllocated(BlockIterator block_it, ProcessId process_id, Size alignment = 0);
+    void markFree(BlockIterator block_it);
+    void recordScan(size_t blocks);
+
+    // Free-block size to search for so an aligned start still leaves
+    // request.size bytes; 0 for an empty request or a bad alignment.
+    Size searchSize(const AllocationRequest& request) const;
+
+    // Splits leading padding off a free block so the returned block starts
+    // on an alignment boundary. The padding stays behind as a free block.
+    BlockIterator alignBlock(BlockIterator block_it, Size alignment);
+
+    // The in-place half of reallocate; failure means the block has to move.
+    virtual AllocationResult resizeInPlace(Address address, Size new_size, ProcessId process_id);
+
+    // What reallocate asks for when the block has to move: new_size with
+    // the block's alignment, plus anything else the allocator keeps about it.
+    virtual AllocationRequest reallocationRequest(Address address, Size new_size, ProcessId process_id) const;
+
+    BlockIterator coalesceNeighbors(BlockIterator block_it);
+
+    void touchHeader(Address block, bool is_write) const
+    {
+        if (metadata_observer_)
+            metadata_observer_(block, is_write);
+    }
+    void touchLink(Address block, bool is_write) const
+    {
+        if (metadata_observer_)
+            metadata_observer_(block + HEADER_BYTES, is_write);
+    }
+    // offset into the out-of-band metadata region.
+    void touchMetadata(size_t offset, bool is_write) const
+    {
+        if (metadata_observer_)
+            metadata_observer_(static_cast<Address>(total_memory_ + offset), is_write);
+    }
+
+    // A size-ordered tree lookup that ended at `found`: the nodes near the
+    // end of the descent are the found block's neighbours in size order,
+    // and those are the reads that tend to miss.
+    void touchSizeIndexPath(map<pair<Size, Address>, BlockIterator>::const_iterator found) const;
+
+    // Called whenever a block enters or leaves the free set (including a
+    // free block changing size). Strategies that keep their own free-block
+    // structure extend these and must call the base version.
+    virtual void indexFreeBlock(BlockIterator block_it);
+    virtual void unindexFreeBlock(BlockIterator block_it);
 };
 
 #endif
@@ -12,7 +12,7 @@ public:
 
     AllocationResult allocate(const AllocationRequest& request) override;
 
-    vector<MemoryBlock>::iterator findFreeBlock(Size size) override;
+    BlockIterator findFreeBlock(Size size) override;
 };
 
 #endif
@@ -0,0 +1,106 @@
+#ifndef BITMAP_ALLOCATOR_HPP
+#define BITMAP_ALLOCATOR_HPP
+
+#include <vector>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <cstdint>
+
+#include "allocator/base_allocator.hpp"
+
+using namespace std;
+
+// Fixed-granularity allocator. Memory is split into unit_size-byte units
+// and one bit per unit records whether it is in use, so there is no
+// per-block list: only the bitmap plus one small record per live
+// allocation. Free runs are found with whole-word scans, and SSE2/AVX2
+// lets fully used or fully free stretches be skipped several words at a
+// time. Placement is first fit in unit order.
+class BitmapAllocator : public BaseAllocator {
+private:
+    struct Allocation {
+        size_t units;
+        size_t align_units;     // 1 unless the request asked for more than unit alignment
+        Size requested_size;
+        ProcessId process_id;
+    };
+
+    Size unit_size_;
+    size_t num_units_;
+    size_t allocated_units_;
+    vector<uint64_t> bitmap_;
+    // Keyed by first unit; the block id handed out is that unit index.
+    unordered_map<size_t, Allocation> allocations_;
+
+    // search_hint_[k]: no free run of at least k units starts below this
+    // unit, so a k-unit search can begin there and still be exact first
+    // fit. Requests above MAX_HINT_UNITS share the last entry.
+    static constexpr size_t MAX_HINT_UNITS = 64;
+    vector<size_t> search_hint_;
+
+    // Free runs as first unit -> length, and the multiset of lengths, kept
+    // by setRange so stats need no bitmap walk. Stats-only bookkeeping:
+    // placement never reads it, and it is not counted as metadata.
+    map<size_t, size_t> free_runs_;
+    multiset<size_t> run_lengths_;
+
+    mutable BlockList snapshot_;
+
+public:
+    BitmapAllocator(Size total_memory, Size unit_size = 16);
+    virtual ~BitmapAllocator() = default;
+
+    void initialize(Size total_memory) override;
+
+    AllocationResult allocate(const AllocationRequest& request) override;
+    bool deallocate(BlockId block_id) override;
+    bool deallocateAddress(Address address, ProcessId process_id) override;
+    size_t deallocateBatch(const vector<Address>& addresses, ProcessId process_id) override;
+    Size allocationSize(Address address, ProcessId process_id) const override;
+
+    MemoryStats getStats() const override;
+    const BlockList& getBlocks() const override;
+    size_t getMetadataBytes() const override;
+
+    // The bitmap never holds adjacent free blocks, so there is nothing to merge.
+    void coalesce() override {}
+
+    // Moved allocations are re-keyed by their new first unit, so their
+    // block ids change along with their addresses.
+    Size compactStep(Size max_bytes, vector<Relocation>& relocations) override;
+
+    BlockIterator findFreeBlock(Size size) override;
+
+    Size getUnitSize() const { return unit_size_; }
+
+protected:
+    AllocationResult resizeInPlace(Address address, Size new_size, ProcessId process_id) override;
+    AllocationRequest reallocationRequest(Address address, Size new_size, ProcessId process_id) const override;
+
+private:
+    static constexpr size_t NPOS = static_cast<size_t>(-1);
+
+    size_t findFreeRun(size_t units, size_t from_unit);
+    bool scanWord(uint64_t word, size_t base, size_t units,
+                  size_t& run, size_t& run_start) const;
+
+    void setRange(size_t first, size_t count, bool allocated);
+    // setRange callers always flip a whole range from one state to the
+    // other, so a range being freed is all in use and one being taken
+    // lies inside a single free run.
+    void addFreeRun(size_t first, size_t count);
+    void takeFromFreeRun(size_t first, size_t count);
+    bool isAllocated(size_t unit) const;
+    size_t nextAllocated(size_t unit) const;
+    size_t nextFree(size_t unit) const;
+    size_t freeRunStart(size_t unit) const;
+
+    // Metadata layout for tracing: the bitmap, then the hints, then the
+    // allocation records as a hash table of 16-byte slots.
+    void touchWords(size_t first_word, size_t count, bool is_write) const;
+    void touchHints(size_t first, size_t count, bool is_write) const;
+    void touchRecord(size_t first_unit, bool is_write) const;
+};
+
+#endif
@@ -2,17 +2,28 @@
 #define FIRST_FIT_HPP
 
 #include "allocator/base_allocator.hpp"
+#include "allocator/free_block_tree.hpp"
 
 using namespace std;
 
 class FirstFitAllocator : public BaseAllocator {
+private:
+    FreeBlockTree free_tree_;
+
 public:
     FirstFitAllocator(Size total_memory);
     virtual ~FirstFitAllocator() = default;
 
+    void initialize(Size total_memory) override;
+    void setMetadataObserver(MetadataObserver observer) override;
+
     AllocationResult allocate(const AllocationRequest& request) override;
 
-    vector<MemoryBlock>::iterator findFreeBlock(Size size) override;
+    BlockIterator findFreeBlock(Size size) override;
+
+protected:
+    void indexFreeBlock(BlockIterator block_it) override;
+    void unindexFreeBlock(BlockIterator block_it) override;
 };
 
 #endif
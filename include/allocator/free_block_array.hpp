@@ -0,0 +1,74 @@
+#ifndef FREE_BLOCK_ARRAY_HPP
+#define FREE_BLOCK_ARRAY_HPP
+
+#include <vector>
+#include <cstdint>
+
+#include "allocator/base_allocator.hpp"
+
+using namespace std;
+
+// Address-ordered free blocks stored as a structure of arrays. Starts and
+// sizes live in separate dense arrays, split into chunks of up to
+// CHUNK_CAPACITY entries, so a fit search streams through sizes only and
+// compares several per instruction. Each chunk also keeps its largest size,
+// so a chunk with nothing big enough is skipped without reading its entries.
+// The list iterators are a third array that is read only on a hit.
+class FreeBlockArray {
+public:
+    static constexpr size_t CHUNK_CAPACITY = 256;
+
+private:
+    struct Chunk {
+        vector<Address> starts;
+        vector<Size> sizes;
+        vector<BlockIterator> blocks;
+        Size max_size;
+    };
+
+    vector<Chunk> chunks_;
+    size_t count_;
+
+    // Gets reads and writes as offsets in a model layout: a directory of
+    // (first start, max size) pairs, then one slab per chunk holding its
+    // three arrays back to back.
+    MetadataObserver observer_;
+    static constexpr size_t DIRECTORY_ENTRY = 16;
+    static constexpr size_t DIRECTORY_BYTES = 64 * 1024;
+    enum Array { STARTS, SIZES, BLOCKS };
+
+public:
+    FreeBlockArray();
+
+    void clear();
+
+    void insert(BlockIterator block);
+    void erase(Address address);
+
+    // First block of at least `size` bytes starting with the one holding
+    // `from` (or the next one above it), wrapping around to the lowest
+    // address once: the next-fit order.
+    bool findNextFit(Size size, Address from, BlockIterator& out, size_t& entries_scanned) const;
+
+    size_t size() const { return count_; }
+    size_t getMetadataBytes() const;
+
+    void setObserver(MetadataObserver observer) { observer_ = move(observer); }
+
+private:
+    // Chunk whose address range holds `address`; chunks_.size() if none.
+    size_t chunkFor(Address address) const;
+    void splitChunk(size_t index);
+    void removeChunk(size_t index);
+    static void refreshMax(Chunk& chunk);
+
+    void touchDirectory(size_t chunk, bool is_write) const;
+    // Cache lines of entries [from, to) of one array of a chunk.
+    void touchEntries(size_t chunk, Array array, size_t from, size_t to, bool is_write) const;
+
+    // Index of the first entry in [from, chunk end) with size >= size, or
+    // the chunk's entry count if none.
+    static size_t scanChunk(const Chunk& chunk, size_t from, Size size);
+};
+
+#endif
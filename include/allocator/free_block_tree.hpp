@@ -0,0 +1,62 @@
+#ifndef FREE_BLOCK_TREE_HPP
+#define FREE_BLOCK_TREE_HPP
+
+#include <vector>
+#include <cstdint>
+
+#include "allocator/base_allocator.hpp"
+
+using namespace std;
+
+// Address-ordered treap of free blocks. Every node also stores the largest
+// free size in its subtree, so the lowest-address (or highest-address) block
+// that fits a request is found in O(log n) without looking at any allocated
+// block.
+class FreeBlockTree {
+private:
+    struct Node {
+        Address address;
+        Size size;
+        Size max_size;
+        uint32_t priority;
+        int left;
+        int right;
+        BlockIterator block;
+    };
+
+    vector<Node> nodes_;
+    vector<int> free_nodes_;
+    int root_;
+    uint32_t seed_;
+    // Gets node reads and writes as offsets into the node array.
+    MetadataObserver observer_;
+
+public:
+    FreeBlockTree();
+
+    void clear();
+
+    void insert(BlockIterator block);
+    void erase(Address address);
+
+    bool findFirstFit(Size size, BlockIterator& out, size_t& nodes_visited) const;
+    bool findLastFit(Size size, BlockIterator& out, size_t& nodes_visited) const;
+
+    bool empty() const { return root_ < 0; }
+
+    void setObserver(MetadataObserver observer) { observer_ = move(observer); }
+
+private:
+    int newNode(BlockIterator block);
+    void update(int node);
+    Size maxSize(int node) const;
+    void touch(int node, bool is_write) const;
+
+    void split(int node, Address address, int& left, int& right);
+    int merge(int left, int right);
+    int eraseFrom(int node, Address address);
+
+    uint32_t nextPriority();
+};
+
+#endif
@@ -0,0 +1,103 @@
+#ifndef LIFETIME_ALLOCATOR_HPP
+#define LIFETIME_ALLOCATOR_HPP
+
+#include <unordered_map>
+#include <deque>
+#include <cstdint>
+
+#include "allocator/base_allocator.hpp"
+#include "allocator/free_block_tree.hpp"
+
+using namespace std;
+
+// First fit that keeps short-lived and long-lived objects apart. Long-lived
+// and unclassified requests take the lowest-address block that fits, as
+// first fit would. Short-lived ones are carved from the end of the
+// highest-address block that fits, so they collect at the top of memory and
+// their space merges back into one region when they die instead of leaving
+// holes between long-lived blocks.
+//
+// A request without a lifetime hint is classified by an online predictor.
+// For each (process, size class) it counts recent objects that died within
+// SHORT_LIFETIME allocations and those that lived longer.
+class LifetimeAllocator : public BaseAllocator {
+public:
+    static constexpr uint64_t SHORT_LIFETIME = 256;
+
+    struct LifetimeStats {
+        size_t hinted;
+        size_t predicted_short;
+        size_t predicted_long;
+        size_t predictions_checked;     // predicted objects that have died
+        size_t predictions_correct;
+        size_t short_placements;        // carved from the top
+    };
+
+private:
+    struct LiveObject {
+        uint64_t born;
+        uint64_t key;
+        bool predicted;
+        bool short_lived;
+        bool aged;      // already counted as long-lived
+    };
+
+    // Deaths per class; both halve once their sum passes HISTORY_WINDOW so
+    // the predictor follows phase changes.
+    struct History {
+        uint32_t short_deaths;
+        uint32_t long_deaths;
+    };
+    static constexpr uint32_t HISTORY_WINDOW = 64;
+
+    FreeBlockTree free_tree_;
+    uint64_t clock_;    // allocation requests so far; object ages are in these
+    unordered_map<BlockId, LiveObject> live_;
+    // Live objects in allocation order. An object still alive once it is
+    // SHORT_LIFETIME old counts as long-lived then, not when it dies, so
+    // objects that are never freed still teach the predictor.
+    deque<pair<uint64_t, BlockId>> young_;
+    unordered_map<uint64_t, History> history_;
+
+    size_t hinted_;
+    size_t predicted_short_;
+    size_t predicted_long_;
+    size_t predictions_checked_;
+    size_t predictions_correct_;
+    size_t short_placements_;
+
+public:
+    LifetimeAllocator(Size total_memory);
+    virtual ~LifetimeAllocator() = default;
+
+    void initialize(Size total_memory) override;
+    void setMetadataObserver(MetadataObserver observer) override;
+
+    AllocationResult allocate(const AllocationRequest& request) override;
+    bool deallocate(BlockId block_id) override;
+    size_t deallocateBatch(const vector<Address>& addresses, ProcessId process_id) override;
+
+    size_t getMetadataBytes() const override;
+
+    // Lowest-address fit, used for long-lived requests.
+    BlockIterator findFreeBlock(Size size) override;
+
+    LifetimeStats getLifetimeStats() const;
+
+protected:
+    void indexFreeBlock(BlockIterator block_it) override;
+    void unindexFreeBlock(BlockIterator block_it) override;
+    // A hinted object moved by realloc keeps its hint; a predicted one is
+    // predicted again.
+    AllocationRequest reallocationRequest(Address address, Size new_size, ProcessId process_id) const override;
+
+private:
+    bool predictShort(uint64_t key) const;
+    void recordDeath(BlockId block_id);
+    void ageObjects();
+    void learn(LiveObject& object, bool died_young);
+
+    static uint64_t historyKey(ProcessId process_id, Size size);
+};
+
+#endif
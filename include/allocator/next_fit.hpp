@@ -0,0 +1,37 @@
+#ifndef NEXT_FIT_HPP
+#define NEXT_FIT_HPP
+
+#include "allocator/base_allocator.hpp"
+#include "allocator/free_block_array.hpp"
+
+using namespace std;
+
+class NextFitAllocator : public BaseAllocator {
+private:
+    // Address where the previous allocation ended; the next search
+    // starts from the block at or after it and wraps around once.
+    Address rover_;
+
+    // Free blocks only, in address order, so a search never walks over
+    // allocated blocks and compares sizes several at a time.
+    FreeBlockArray free_array_;
+
+public:
+    NextFitAllocator(Size total_memory);
+    virtual ~NextFitAllocator() = default;
+
+    void initialize(Size total_memory) override;
+    void setMetadataObserver(MetadataObserver observer) override;
+
+    AllocationResult allocate(const AllocationRequest& request) override;
+
+    BlockIterator findFreeBlock(Size size) override;
+
+    size_t getMetadataBytes() const override;
+
+protected:
+    void indexFreeBlock(BlockIterator block_it) override;
+    void unindexFreeBlock(BlockIterator block_it) override;
+};
+
+#endif
@@ -0,0 +1,143 @@
+#ifndef PTMALLOC_HPP
+#define PTMALLOC_HPP
+
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <unordered_set>
+#include <cstdint>
+
+#include "allocator/base_allocator.hpp"
+
+using namespace std;
+
+// Model of glibc malloc (ptmalloc2) on the block list. Requests become
+// 16-byte-aligned chunks with an 8-byte header. A free chunk is parked in
+// its tcache slot or fastbin if it is small: it stays in use as far as the
+// heap is concerned and is never merged. Anything else is freed and merged
+// with its neighbours right away. malloc tries the tcache, the fastbin and
+// the exact smallbin first. Only then does it search the bins, from the
+// request's own bin up, using a binmap to skip empty ones. Last comes the
+// top chunk, the free space at the end of the heap, whose break is raised
+// in 4 KB steps as it is carved.
+class PtmallocAllocator : public BaseAllocator {
+public:
+    enum Tier { TCACHE, FASTBIN, SMALLBIN, LARGEBIN, TOP, TIER_COUNT };
+
+    struct BinStats {
+        size_t lookups[TIER_COUNT];
+        size_t hits[TIER_COUNT];
+        size_t fast_path;           // served by tcache, fastbin or exact smallbin
+        size_t consolidations;      // fastbins (and tcache) flushed to the heap
+        size_t top_extensions;      // times the break moved up
+        Address heap_top;           // current break
+        size_t cached_chunks;       // sitting in tcache or fastbins
+        Size cached_bytes;
+    };
+
+    static constexpr Size CHUNK_HEADER = 8;
+    static constexpr Size CHUNK_ALIGN = 16;
+    static constexpr Size MIN_CHUNK = 32;
+    static constexpr size_t TCACHE_BINS = 64;
+    static constexpr size_t TCACHE_COUNT = 7;
+    static constexpr Size MAX_FAST = 128;
+    static constexpr Size MIN_LARGE = 1024;
+    static constexpr size_t NBINS = 128;
+    static constexpr size_t NSMALLBINS = MIN_LARGE / CHUNK_ALIGN;
+    // Freeing a chunk that merges to this size flushes the fastbins.
+    static constexpr Size CONSOLIDATE_THRESHOLD = 64 * 1024;
+    static constexpr Size TOP_PAD = 128 * 1024;
+    static constexpr Size BRK_PAGE = 4096;
+
+private:
+    // Cached chunks stay ALLOCATED with no owner; the caches are LIFO.
+    vector<vector<BlockIterator>> tcache_;
+    vector<vector<BlockIterator>> fastbins_;
+    unordered_set<Address> cached_;
+    Size cached_bytes_;
+
+    // Smallbins hold one 16-byte size class each and are FIFO (newest at
+    // the front, taken from the back). Largebins cover a range and are
+    // sorted by size, smallest first.
+    vector<list<BlockIterator>> bins_;
+    unordered_map<Address, list<BlockIterator>::iterator> bin_pos_;
+    uint32_t binmap_[NBINS / 32];
+
+    // The free block that ends at total_memory_, if any. It is never binned.
+    BlockIterator top_;
+    bool has_top_;
+    Address brk_;
+
+    size_t lookups_[TIER_COUNT];
+    size_t hits_[TIER_COUNT];
+    size_t fast_path_;
+    size_t consolidations_;
+    size_t top_extensions_;
+
+public:
+    PtmallocAllocator(Size total_memory);
+    virtual ~PtmallocAllocator() = default;
+
+    void initialize(Size total_memory) override;
+
+    AllocationResult allocate(const AllocationRequest& request) override;
+    bool deallocate(BlockId block_id) override;
+    size_t deallocateBatch(const vector<Address>& addresses, ProcessId process_id) override;
+    Size allocationSize(Address address, ProcessId process_id) const override;
+
+    // Cached chunks count as free memory.
+    MemoryStats getStats() const override;
+    size_t getMetadataBytes() const override;
+
+    // Flushes the caches first so their chunks can merge and move.
+    Size compactStep(Size max_bytes, vector<Relocation>& relocations) override;
+
+    // Bin search: best fit in the request's own bin, then the smallest
+    // chunk of the next non-empty bin, then the top chunk.
+    BlockIterator findFreeBlock(Size size) override;
+
+    BinStats getBinStats() const;
+
+    static Size chunkSize(Size request);
+
+protected:
+    AllocationResult resizeInPlace(Address address, Size new_size, ProcessId process_id) override;
+
+    void indexFreeBlock(BlockIterator block_it) override;
+    void unindexFreeBlock(BlockIterator block_it) override;
+
+private:
+    // tcache, fastbin, then exact smallbin; end() if none has a chunk.
+    BlockIterator takeCached(Size chunk_size);
+    // Parks an in-use chunk (already unowned) in a cache.
+    void cacheChunk(vector<BlockIterator>& cache, BlockIterator block_it);
+    // Frees every fastbin chunk (and tcache chunk if asked) into the heap.
+    size_t consolidate(bool include_tcache);
+    bool haveFastChunks() const;
+
+    void extendTop(Address end);
+
+    static size_t binIndex(Size size);
+    static size_t tcacheIndex(Size chunk_size);
+    static size_t fastbinIndex(Size chunk_size);
+    size_t nextNonEmptyBin(size_t from) const;
+
+    // Metadata layout for tracing, as in glibc: the tcache struct (2-byte
+    // counts, then entry pointers), then the arena with its fastbin heads,
+    // top pointer, two-pointer bin heads and the binmap.
+    static constexpr size_t TCACHE_ENTRIES = TCACHE_BINS * 2;
+    static constexpr size_t ARENA = TCACHE_ENTRIES + TCACHE_BINS * 8;
+    static constexpr size_t ARENA_FASTBINS = ARENA + 16;
+    static constexpr size_t ARENA_TOP = ARENA + 96;
+    static constexpr size_t ARENA_BINS = ARENA + 112;
+    static constexpr size_t ARENA_BINMAP = ARENA_BINS + NBINS * 16;
+    void touchTcache(size_t index, bool is_write) const {
+        touchMetadata(index * 2, is_write);
+        touchMetadata(TCACHE_ENTRIES + index * 8, is_write);
+    }
+    void touchFastbin(size_t index, bool is_write) const { touchMetadata(ARENA_FASTBINS + index * 8, is_write); }
+    void touchBin(size_t index, bool is_write) const { touchMetadata(ARENA_BINS + index * 16, is_write); }
+    void touchBinmap(size_t index, bool is_write) const { touchMetadata(ARENA_BINMAP + index / 32 * 4, is_write); }
+};
+
+#endif
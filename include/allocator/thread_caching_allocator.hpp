@@ -0,0 +1,154 @@
+#ifndef THREAD_CACHING_ALLOCATOR_HPP
+#define THREAD_CACHING_ALLOCATOR_HPP
+
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <functional>
+
+#include "allocator/base_allocator.hpp"
+#include "buddy/buddy_allocator.hpp"
+
+using namespace std;
+
+// Thread-safe front end for a physical or buddy allocator. Every thread
+// attaches a ThreadCache that serves small requests from private
+// per-size-class free lists. The caches refill from and flush to a central
+// transfer list in batches, so the shared lock is taken once per batch
+// rather than once per request. Large requests go straight to the back end
+// under the lock.
+//
+// Small objects are carved from spans: one back-end block holding a batch
+// of objects of one class. A page map finds the span of any address
+// without the lock, and each span's bitmap of objects handed out rejects
+// double and foreign frees. Once a class's central list holds more than
+// CENTRAL_HIGH_WATERMARK batches, spans whose objects are all back in it
+// are returned to the back end.
+class ThreadCachingAllocator
+{
+public:
+    static constexpr Size CLASS_GRANULE = 16;
+    static constexpr Size MAX_SMALL_SIZE = 1024;
+    static constexpr size_t CLASS_COUNT = MAX_SMALL_SIZE / CLASS_GRANULE;
+    static constexpr size_t BATCH_SIZE = 32;
+    static constexpr size_t CENTRAL_HIGH_WATERMARK = 8;
+
+    // Every span is a whole number of map pages, and aligned to one.
+    static constexpr Size SPAN_ALIGNMENT = CLASS_GRANULE * BATCH_SIZE;
+
+    // What the front end needs from a back end.
+    struct Backend
+    {
+        Size memory_size;
+        function<AllocationResult(const AllocationRequest &)> allocate;
+        function<bool(Address, ProcessId)> deallocate;
+    };
+
+    struct Stats
+    {
+        size_t lock_acquisitions;
+        size_t batches_fetched;
+        size_t batches_returned;
+        size_t spans_carved;
+        size_t spans_released;
+        size_t invalid_frees;
+    };
+
+    class ThreadCache
+    {
+    private:
+        ThreadCachingAllocator &owner_;
+        ProcessId process_id_;
+        vector<vector<Address>> free_lists_;
+
+    public:
+        ThreadCache(ThreadCachingAllocator &owner, ProcessId process_id);
+        ~ThreadCache();
+
+        ThreadCache(const ThreadCache &) = delete;
+        ThreadCache &operator=(const ThreadCache &) = delete;
+
+        AllocationResult allocate(Size size);
+
+        // Sized free: the caller passes the size it asked for, which picks
+        // the class without a shared address -> class lookup. Addresses
+        // not handed out for that class are refused.
+        bool deallocate(Address address, Size size);
+
+        // Returns every cached object to the central lists.
+        void flush();
+    };
+
+private:
+    struct Span
+    {
+        Address start;
+        size_t size_class;
+        ProcessId process_id;
+        // Bit i is set while object i is with a caller.
+        atomic<uint32_t> live;
+        // Objects sitting in central batches; guarded by lock_.
+        size_t central_objects;
+        bool releasing;
+    };
+    static_assert(BATCH_SIZE == 32, "span bitmaps are 32 bits wide");
+
+    Backend backend_;
+    mutex lock_;
+    vector<vector<vector<Address>>> central_batches_;
+    // Spans of each class whose objects are all in the central list.
+    vector<size_t> releasable_spans_;
+
+    // One entry per SPAN_ALIGNMENT bytes of back-end memory. Written under
+    // lock_, read without it. Span records are recycled rather than freed,
+    // so a lookup racing with a release never reads freed memory.
+    unique_ptr<atomic<Span *>[]> page_map_;
+    size_t page_count_;
+    vector<unique_ptr<Span>> spans_;
+    vector<Span *> spare_spans_;
+
+    atomic<size_t> lock_acquisitions_;
+    atomic<size_t> batches_fetched_;
+    atomic<size_t> batches_returned_;
+    atomic<size_t> spans_carved_;
+    atomic<size_t> spans_released_;
+    atomic<size_t> invalid_frees_;
+
+public:
+    explicit ThreadCachingAllocator(Backend backend);
+
+    // Thread caches must be gone first. Spans that are entirely free go
+    // back to the back end.
+    ~ThreadCachingAllocator();
+
+    Stats getStats() const;
+
+    static Backend backendFor(BaseAllocator &allocator);
+    static Backend backendFor(BuddyAllocator &allocator);
+
+    static bool isSmall(Size size) { return size > 0 && size <= MAX_SMALL_SIZE; }
+    static size_t sizeClass(Size size) { return (size + CLASS_GRANULE - 1) / CLASS_GRANULE - 1; }
+    static Size classSize(size_t size_class) { return (size_class + 1) * CLASS_GRANULE; }
+
+private:
+    bool fetchBatch(size_t size_class, ProcessId process_id, vector<Address> &out);
+    void returnBatch(size_t size_class, vector<Address> &&batch);
+
+    AllocationResult allocateLarge(Size size, ProcessId process_id);
+    bool deallocateLarge(Address address, ProcessId process_id);
+
+    Span *spanFor(Address address) const;
+    Span *carveSpan(size_t size_class, ProcessId process_id);
+    // Drops the objects of entirely free spans from the central list and
+    // frees those spans. Called with lock_ held.
+    void releaseFreeSpans(size_t size_class);
+
+    // Flip an object's bit in its span's bitmap. markReturned fails, and
+    // counts an invalid free, unless the address is an object of the class
+    // that is currently with a caller.
+    void markHandedOut(Address address);
+    bool markReturned(Address address, size_t size_class);
+};
+
+#endif
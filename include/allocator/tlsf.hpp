@@ -0,0 +1,58 @@
+#ifndef TLSF_HPP
+#define TLSF_HPP
+
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <cstdint>
+
+#include "allocator/base_allocator.hpp"
+
+using namespace std;
+
+// Two-level segregated fit. Free blocks are binned by size into a
+// first level (power of two) and SL_COUNT linear second-level classes per
+// first level. One bitmap per level marks the non-empty bins, so finding a
+// bin that fits is two find-first-set operations, and insert and remove
+// are O(1).
+class TlsfAllocator : public BaseAllocator {
+private:
+    static constexpr int SL_LOG2 = 4;
+    static constexpr int SL_COUNT = 1 << SL_LOG2;
+    static constexpr int FL_COUNT = 64 - SL_LOG2 + 1;
+
+    uint64_t fl_bitmap_;
+    uint32_t sl_bitmap_[FL_COUNT];
+    vector<list<BlockIterator>> free_lists_;
+    unordered_map<Address, list<BlockIterator>::iterator> free_list_pos_;
+
+public:
+    TlsfAllocator(Size total_memory);
+    virtual ~TlsfAllocator() = default;
+
+    void initialize(Size total_memory) override;
+
+    AllocationResult allocate(const AllocationRequest& request) override;
+
+    BlockIterator findFreeBlock(Size size) override;
+
+protected:
+    void indexFreeBlock(BlockIterator block_it) override;
+    void unindexFreeBlock(BlockIterator block_it) override;
+
+private:
+    // Bin holding blocks of exactly this size.
+    void mappingInsert(Size size, int& fl, int& sl) const;
+    // Smallest bin whose every block is at least this size.
+    bool mappingSearch(Size size, int& fl, int& sl) const;
+
+    list<BlockIterator>& binFor(int fl, int sl);
+
+    // The control block is fl_bitmap_, sl_bitmap_ and then the bin heads.
+    static constexpr size_t SL_BITMAP_OFFSET = sizeof(uint64_t);
+    static constexpr size_t HEADS_OFFSET = 256;
+    void touchSlBitmap(int fl, bool is_write) const { touchMetadata(SL_BITMAP_OFFSET + fl * sizeof(uint32_t), is_write); }
+    void touchHead(int fl, int sl, bool is_write) const { touchMetadata(HEADS_OFFSET + (fl * SL_COUNT + sl) * 8, is_write); }
+};
+
+#endif
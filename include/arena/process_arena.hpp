@@ -0,0 +1,70 @@
+#ifndef PROCESS_ARENA_HPP
+#define PROCESS_ARENA_HPP
+
+#include <map>
+#include <vector>
+
+#include "allocator/base_allocator.hpp"
+#include "common/types.hpp"
+
+using namespace std;
+
+// Bump-pointer region owned by one process. The arena takes large chunks
+// from the physical allocator and carves requests out of them, so tearing
+// the process down returns a handful of chunks instead of every object.
+class ProcessArena
+{
+public:
+    static constexpr Size DEFAULT_CHUNK_SIZE = 16 * 1024;
+    static constexpr Size ALIGNMENT = 16;
+
+private:
+    // Objects are recorded in carve order, so they are sorted by address;
+    // a freed object keeps its slot with size 0 until it can be trimmed.
+    struct Chunk
+    {
+        Size size;
+        Size used;
+        size_t live_objects;
+        vector<pair<Address, Size>> objects;
+    };
+
+    Size chunk_size_;
+    map<Address, Chunk> chunks_;
+    Address current_;
+    bool has_current_;
+    size_t live_objects_;
+
+public:
+    explicit ProcessArena(Size chunk_size = DEFAULT_CHUNK_SIZE);
+
+    AllocationResult allocate(BaseAllocator &backing, const AllocationRequest &request);
+
+    // Frees one object. Space at the top of the current chunk is reused;
+    // any other chunk goes back to the backing allocator once it is empty.
+    bool deallocate(BaseAllocator &backing, Address address, ProcessId process_id);
+
+    // Returns every chunk to the backing allocator in one pass.
+    size_t releaseAll(BaseAllocator &backing, ProcessId process_id);
+
+    // Forgets all chunks without freeing them (the backing heap is gone).
+    void reset();
+
+    // Follows a chunk moved by heap compaction. Returns false if the block
+    // is not one of this arena's chunks; otherwise appends the old and new
+    // address of every live object in it.
+    bool relocateChunk(Address old_base, Address new_base, vector<pair<Address, Address>> &moved_objects);
+
+    bool owns(Address address) const;
+    // Rounded size of the live object at address, or 0 if there is none.
+    Size objectSize(Address address) const;
+    size_t objectCount() const { return live_objects_; }
+    size_t chunkCount() const { return chunks_.size(); }
+    Size reservedBytes() const;
+
+private:
+    // Index of the live object at address, or objects.size() if none.
+    static size_t findObject(const Chunk &chunk, Address address);
+};
+
+#endif
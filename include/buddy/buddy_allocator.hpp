@@ -3,7 +3,6 @@
 
 #include <vector>
 #include <unordered_map>
-#include <list>
 
 #include "common/types.hpp"
 
@@ -16,41 +15,148 @@ private:
     size_t allocation_successes_ = 0;
     size_t allocation_failures_ = 0;
     Size internal_fragmentation_ = 0;
+    size_t realloc_in_place_ = 0;
+    size_t realloc_moved_ = 0;
+    Size realloc_bytes_copied_ = 0;
+    size_t aligned_allocations_ = 0;
+    Size alignment_waste_ = 0;
+    size_t exact_allocations_ = 0;
+    Size exact_trimmed_ = 0;
     Size total_memory_;
     int max_order_;
-    vector<list<Address>> free_lists_;
-    unordered_map<Address, tuple<int, ProcessId, Size>> allocated_blocks_;
+
+    // Free blocks form one doubly linked list per order, threaded through
+    // the blocks themselves: a node holds the block's order (its free bit)
+    // and its neighbours' addresses, so testing a buddy and unlinking it
+    // are single lookups. Bit k of nonempty_orders_ is set while order k's
+    // list has a block, and allocation picks an order with one bit scan.
+    struct FreeNode
+    {
+        int order;
+        Address prev;
+        Address next;
+    };
+    struct FreeList
+    {
+        Address head;
+        Address tail;
+        size_t count;
+    };
+    static constexpr Address NIL = ~static_cast<Address>(0);
+
+    unordered_map<Address, FreeNode> free_nodes_;
+    vector<FreeList> free_lists_;
+    uint64_t nonempty_orders_ = 0;
+    // Where each order's free bitmap starts in the modeled metadata.
+    vector<Size> bitmap_offsets_;
+    // Order, owner, requested size, and whether the block was trimmed to
+    // that size by allocateExact.
+    unordered_map<Address, tuple<int, ProcessId, Size, bool>> allocated_blocks_;
+
+    // Kept up to date by allocate/deallocate/reallocate and the free-list
+    // operations, so getStats never walks the table or the lists.
+    Size used_bytes_ = 0;
+    size_t free_blocks_ = 0;
+
+    // Set while metadata tracing is on. Free-list nodes live in the free
+    // blocks themselves; the list heads and the table of allocated blocks
+    // are modeled past the end of memory.
+    MetadataObserver metadata_observer_;
 
 
 
 
 public:
+    // Any size works: memory that is not a power of two starts out as
+    // several maximal blocks (see initialize), and no block ever merges
+    // past the end.
     BuddyAllocator(Size total_memory);
     ~BuddyAllocator() = default;
 
     void initialize();
 
+    // Blocks are aligned to their own size, so an alignment above the
+    // rounded request size is met by taking a block of that order.
     AllocationResult allocate(const AllocationRequest &request);
 
+    // Like allocate, but keeps only request.size bytes of the block, as
+    // alloc_pages_exact does: the tail is split into whole buddies and
+    // freed at once, so nothing is lost to rounding. Freeing the block
+    // releases the kept range piece by piece and it merges back with the
+    // tail. Shrinking stays in place; growing moves.
+    AllocationResult allocateExact(const AllocationRequest &request);
+
     bool deallocate(Address address);
 
+    // Resizes a live block. It stays put if the new size needs the same
+    // order, or a lower one (the upper halves are split off and freed), or
+    // a higher one whose buddies at every level up are free. Otherwise it
+    // moves; on failure the old block is left untouched.
+    AllocationResult reallocate(Address address, Size new_size);
+
+    vector<AllocationResult> allocateBatch(const vector<Size> &sizes, ProcessId process_id,
+                                           bool exact = false);
+    // Frees through freeBulk.
+    size_t deallocateBatch(const vector<Address> &addresses);
+
+    // Takes up to count blocks of one order, carving each free block it
+    // picks in a single pass instead of splitting once per block. Returns
+    // the addresses it got, lowest first within each carved block; fewer
+    // than count means memory ran out.
+    vector<Address> allocateBulk(int order, size_t count, ProcessId process_id);
+
+    // Frees a set of live blocks. Adjacent blocks are released as one
+    // range, so a contiguous run merges back in a few steps. Unknown
+    // addresses are skipped; returns how many blocks were freed.
+    size_t freeBulk(const vector<Address> &addresses);
+
     MemoryStats getStats() const;
 
     vector<MemoryBlock> getAllocatedBlocks() const;
     vector<MemoryBlock> getFreeBlocks() const;
 
+    void setMetadataObserver(MetadataObserver observer);
+
 private:
     int getOrder(Size size) const;
 
+    AllocationResult allocateBlock(const AllocationRequest &request, bool exact);
+    AllocationResult reallocateExact(Address address, Size new_size);
+
+    // Frees [start, end) as the largest self-aligned blocks that fit.
+    void releaseRange(Address start, Address end);
+
     Address getBuddyAddress(Address address, int order) const;
 
     void splitBlock(int order);
 
     void mergeBuddies(int order, Address address);
 
+    bool growInPlace(Address address, int order, int new_order);
+
+    // Alignment a block of this order has to keep when it moves to hold
+    // new_size bytes: its own block size, or 0 if any block that size
+    // already has it.
+    Size movedAlignment(int order, Size new_size) const;
+
     bool isValidAddress(Address address, int order) const;
 
     Size getBlockSize(int order) const;
+
+    // Free-list operations that also report the memory they touch.
+    void pushFree(int order, Address address);
+    Address popFree(int order);
+    bool isFree(int order, Address address) const;
+    void unlinkFree(int order, Address address);
+
+    // Lowest order at or above `order` with a free block, or -1.
+    int firstFreeOrder(int order) const;
+
+    void touchMask(bool is_write) const;
+    void touchHead(int order, bool is_write) const;
+    void touchBit(int order, Address address, bool is_write) const;
+    void touchNode(Address address, bool is_write) const;
+    void touchRecord(Address address, bool is_write) const;
 };
 
 #endif
@@ -0,0 +1,86 @@
+#ifndef PAGE_CACHE_HPP
+#define PAGE_CACHE_HPP
+
+#include <vector>
+#include <unordered_set>
+
+#include "buddy/buddy_allocator.hpp"
+#include "common/types.hpp"
+
+using namespace std;
+
+// Hot page list owned by one process, in front of the buddy allocator, as
+// Linux keeps per-CPU page lists. Single-page allocations and frees are
+// served from the list; the buddy free lists are only touched to refill an
+// empty list or to drain one that grew past its high watermark, and then
+// in one bulk call. Cached pages stay allocated in the buddy allocator, to
+// the owning process; reports count them as free (see Stats).
+class PageCache
+{
+public:
+    static constexpr size_t DEFAULT_LOW = 4;
+    static constexpr size_t DEFAULT_HIGH = 16;
+
+    struct Stats
+    {
+        size_t allocations;
+        size_t allocation_hits;     // served without touching the buddy lists
+        size_t allocation_failures;
+        size_t frees;
+        size_t free_hits;
+        size_t refills;
+        size_t drains;
+        size_t pages_requested;     // asked of allocateBulk, to undo its counts
+        size_t pages_refilled;
+        size_t pages_drained;
+        size_t cached_pages;        // free pages sitting in the list
+        size_t pages_in_use;
+
+        Stats &operator+=(const Stats &other);
+    };
+
+private:
+    Size page_size_;
+    ProcessId process_id_;
+    // An empty list is refilled up to low; a list above high is drained
+    // back down to low. high == 0 turns the cache off.
+    size_t low_;
+    size_t high_;
+
+    // Free pages, used LIFO so the most recently freed (cache-hot) page
+    // goes out first.
+    vector<Address> free_pages_;
+    unordered_set<Address> in_use_;
+    Stats stats_;
+
+public:
+    explicit PageCache(Size page_size = 4096, ProcessId process_id = -1,
+                       size_t low = DEFAULT_LOW, size_t high = DEFAULT_HIGH);
+
+    bool enabled() const { return high_ > 0; }
+
+    // Returns the free pages first, so the new limits start from empty.
+    void setWatermarks(BuddyAllocator &buddy, size_t low, size_t high);
+
+    AllocationResult allocate(BuddyAllocator &buddy);
+    bool deallocate(BuddyAllocator &buddy, Address address);
+
+    // Gives every free page back to the buddy allocator in one bulk free.
+    size_t drain(BuddyAllocator &buddy);
+
+    // Frees the pages in use and drains the list, for process teardown.
+    size_t releaseAll(BuddyAllocator &buddy);
+
+    // Forgets all pages without freeing them (the buddy allocator is gone).
+    void reset();
+
+    bool owns(Address address) const { return in_use_.count(address) > 0; }
+    size_t pageCount() const { return in_use_.size(); }
+    Stats getStats() const;
+
+private:
+    // Moves free pages beyond `keep` back to the buddy allocator.
+    void shrinkTo(BuddyAllocator &buddy, size_t keep);
+};
+
+#endif
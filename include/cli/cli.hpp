@@ -23,6 +23,9 @@ private:
     ProcessId current_process_;
     bool handleAllocatorMode(const vector<string> &args);
     bool handleColor(const vector<string> &args);
+    bool handleMetadataTrace(const vector<string> &args);
+    bool handleBuddyExact(const vector<string> &args);
+    bool handlePageCache(const vector<string> &args);
 
 
 
@@ -44,6 +47,12 @@ private:
     bool handleTerminateProcess(const vector<string>& args);
     bool handleAllocate(const vector<string>& args);
     bool handleDeallocate(const vector<string>& args);
+    bool handleReallocate(const vector<string>& args);
+    bool handleAllocateBatch(const vector<string>& args);
+    bool handleAllocateBulk(const vector<string>& args);
+    bool handleCompact(const vector<string>& args);
+    bool handleRelocation(const vector<string>& args);
+    bool handleDeallocateBatch(const vector<string>& args);
     bool handleAccess(const vector<string>& args);
     bool handleDump(const vector<string>& args);
     bool handleStats(const vector<string>& args);
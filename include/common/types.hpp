@@ -3,11 +3,12 @@
 
 #include <cstdint>
 #include <cstddef>
+#include <functional>
 
-using Address = uint32_t;
-using Size = uint32_t;
+using Address = uint64_t;
+using Size = uint64_t;
 using ProcessId = int;
-using BlockId = int;
+using BlockId = int64_t;
 
 enum class BlockStatus
 {
@@ -19,14 +20,29 @@ enum class AllocationStrategy
 {
     FIRST_FIT,
     BEST_FIT,
-    WORST_FIT
+    WORST_FIT,
+    NEXT_FIT,
+    TLSF,
+    BITMAP,
+    PTMALLOC,
+    LIFETIME
+};
+
+// Expected lifetime of an allocation, as a placement hint.
+enum class LifetimeHint
+{
+    UNKNOWN,
+    SHORT,
+    LONG
 };
 enum class AllocationMode
 {
     AUTO,       // decide automatically (power-of-two → buddy)
     PHYSICAL,   // always use physical allocator
     BUDDY,
-    FORCED    // always use buddy allocator
+    FORCED,   // always use buddy allocator
+    SLAB,     // small requests to slab caches, the rest to physical
+    ARENA     // carve requests from per-process arena chunks
 };
 
 
@@ -59,6 +75,7 @@ struct MemoryBlock
     ProcessId process_id;
     BlockId block_id;
     Size requested_size;
+    Size alignment;     // of a live aligned allocation (0 = none); compaction keeps it
 
     MemoryBlock(
         Address addr = 0,
@@ -70,7 +87,9 @@ struct MemoryBlock
           size(sz),
           status(st),
           process_id(pid),
-          block_id(bid) {}
+          block_id(bid),
+          requested_size(0),
+          alignment(0) {}
 
     bool isFree() const
     {
@@ -104,11 +123,26 @@ struct AllocationRequest
 {
     Size size;
     ProcessId process_id;
+    Size alignment;     // power of two; 0 or 1 means no constraint
+    LifetimeHint lifetime;
 
-    AllocationRequest(Size sz = 0, ProcessId pid = -1)
-        : size(sz), process_id(pid) {}
+    AllocationRequest(Size sz = 0, ProcessId pid = -1, Size align = 0,
+                      LifetimeHint life = LifetimeHint::UNKNOWN)
+        : size(sz), process_id(pid), alignment(align), lifetime(life) {}
 };
 
+// One block moved by heap compaction.
+struct Relocation
+{
+    Address old_address;
+    Address new_address;
+    Size size;
+    ProcessId process_id;
+};
+
+// Receives an allocator's simulated metadata accesses as (address, is_write).
+using MetadataObserver = std::function<void(Address, bool)>;
+
 struct AllocationResult
 {
     bool success;
@@ -133,6 +167,16 @@ struct MemoryStats
     size_t allocation_requests;
     size_t allocation_successes;
     size_t allocation_failures;
+    size_t blocks_scanned;
+    size_t longest_scan;
+    size_t realloc_in_place;
+    size_t realloc_moved;
+    Size realloc_bytes_copied;
+    size_t aligned_allocations;
+    Size alignment_waste;
+    // Buddy blocks trimmed to their request, and the bytes handed back.
+    size_t exact_allocations;
+    Size exact_trimmed;
     double memory_utilization=0.0;
 
     MemoryStats()
@@ -147,7 +191,16 @@ struct MemoryStats
           internal_fragmentation(0),
           allocation_requests(0),
           allocation_successes(0),
-          allocation_failures(0)
+          allocation_failures(0),
+          blocks_scanned(0),
+          longest_scan(0),
+          realloc_in_place(0),
+          realloc_moved(0),
+          realloc_bytes_copied(0),
+          aligned_allocations(0),
+          alignment_waste(0),
+          exact_allocations(0),
+          exact_trimmed(0)
     {}
 };
 
@@ -22,16 +22,62 @@ inline Size nextPowerOfTwo(Size n) {
     n |= n >> 4;
     n |= n >> 8;
     n |= n >> 16;
+    n |= n >> 32;
     n++;
     return n;
 }
 
+// alignment must be a power of two; 0 and 1 leave value unchanged.
+inline Address alignUp(Address value, Size alignment) {
+    if (alignment <= 1) return value;
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
 inline int log2Floor(Size n) {
     int log = 0;
     while (n >>= 1) log++;
     return log;
 }
 
+// Index of the lowest / highest set bit. Undefined for 0.
+inline int findFirstSet(uint32_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctz(mask);
+#else
+    int index = 0;
+    while (!(mask & 1u)) { mask >>= 1; index++; }
+    return index;
+#endif
+}
+
+inline int findFirstSet64(uint64_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(mask);
+#else
+    int index = 0;
+    while (!(mask & 1ull)) { mask >>= 1; index++; }
+    return index;
+#endif
+}
+
+inline int findLastSet(uint32_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 31 - __builtin_clz(mask);
+#else
+    return log2Floor(mask);
+#endif
+}
+
+inline int findLastSet64(uint64_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(mask);
+#else
+    int index = 0;
+    while (mask >>= 1) index++;
+    return index;
+#endif
+}
+
 inline vector<string> splitString(const string& str, char delimiter) {
     vector<string> tokens;
     stringstream ss(str);
@@ -49,11 +95,11 @@ inline string formatAddress(Address addr) {
 }
 
 inline string formatSize(Size size) {
-    const char* units[] = {"B", "KB", "MB", "GB"};
+    const char* units[] = {"B", "KB", "MB", "GB", "TB", "PB"};
     int unitIndex = 0;
     double displaySize = static_cast<double>(size);
 
-    while (displaySize >= 1024.0 && unitIndex < 3) {
+    while (displaySize >= 1024.0 && unitIndex < 5) {
         displaySize /= 1024.0;
         unitIndex++;
     }
@@ -3,22 +3,53 @@
 
 #include <memory>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <string>
 
 #include "allocator/base_allocator.hpp"
+#include "allocator/ptmalloc.hpp"
+#include "allocator/lifetime_allocator.hpp"
+#include "arena/process_arena.hpp"
 #include "buddy/buddy_allocator.hpp"
+#include "buddy/page_cache.hpp"
+#include "slab/slab_allocator.hpp"
 #include "cache/cache_hierarchy.hpp"
 #include "virtual_memory/vmm.hpp"
 #include "common/types.hpp"
 
 using namespace std;
 
+// Live allocations of one process, split by the allocator that owns them
+// so a free goes straight to the right back end.
+struct ProcessAllocations
+{
+    unordered_set<Address> physical;
+    unordered_set<Address> buddy;
+    unordered_set<Address> slab;
+    ProcessArena arena;
+    PageCache pages;
+
+    size_t size() const
+    {
+        return physical.size() + buddy.size() + slab.size() + arena.objectCount() + pages.pageCount();
+    }
+};
+
 class IntegratedMemorySystem
 {
 private:
+    enum class AllocationTarget
+    {
+        PHYSICAL,
+        BUDDY,
+        SLAB,
+        ARENA
+    };
+
     unique_ptr<BaseAllocator> physical_allocator_;
     unique_ptr<BuddyAllocator> buddy_allocator_;
+    unique_ptr<SlabAllocator> slab_allocator_;
     unique_ptr<CacheHierarchy> cache_hierarchy_;
     unique_ptr<VirtualMemoryManager> virtual_memory_manager_;
     AllocationMode allocation_mode_;
@@ -29,14 +60,58 @@ private:
     PageReplacementPolicy page_replacement_policy_;
     bool initialized_;
 
-    unordered_map<ProcessId, vector<Address>> process_allocations_;
+    unordered_map<ProcessId, ProcessAllocations> process_allocations_;
+
+    // Heap compaction: auto-trigger settings, the current address for every
+    // address a block has been moved away from, and the reverse (current ->
+    // earlier addresses) so a block that moves again updates all of them.
+    double compaction_threshold_;
+    Size compaction_step_bytes_;
+    unordered_map<Address, Address> relocated_to_;
+    unordered_map<Address, vector<Address>> relocated_from_;
+
+    // Buddy requests are trimmed to their size (allocateExact) when set.
+    bool buddy_exact_;
+
+    // Watermarks for every process's page cache (high 0 = off), and the
+    // counters of caches whose processes are gone.
+    size_t page_cache_low_;
+    size_t page_cache_high_;
+    PageCache::Stats retired_page_cache_stats_;
+
+    // Reallocations that had to move a slab object, an arena object or a
+    // cached page, charged to the allocator the old memory came from.
+    struct ReallocMoves
+    {
+        size_t moved = 0;
+        Size bytes_copied = 0;
+    };
+    ReallocMoves slab_realloc_moves_;
+    ReallocMoves arena_realloc_moves_;
+    ReallocMoves page_realloc_moves_;
 
     size_t total_operations_;
     size_t cache_hits_;
     size_t cache_misses_;
     size_t page_faults_;
 
+    // Allocator metadata tracing: while on, every header, link, bin and
+    // bitmap access of the physical and buddy allocators goes through the
+    // cache hierarchy.
+    bool metadata_tracing_;
+    size_t metadata_accesses_;
+    size_t metadata_misses_;
+    size_t metadata_allocations_;
+
 public:
+    struct MetadataTrafficStats
+    {
+        bool enabled;
+        size_t accesses;
+        size_t misses;          // went all the way to main memory
+        size_t allocations;     // physical and buddy requests while tracing
+    };
+
     IntegratedMemorySystem(
         Size total_memory,
         Size page_size = 4096,
@@ -47,23 +122,76 @@ public:
     bool hasProcess(ProcessId pid) const;
     ~IntegratedMemorySystem() = default;
     MemoryStats getPhysicalAllocatorStats() const;
+    // Bin counters of the ptmalloc strategy; all zero under any other.
+    PtmallocAllocator::BinStats getPtmallocStats() const;
+    // Predictor counters of the lifetime strategy; all zero under any other.
+    LifetimeAllocator::LifetimeStats getLifetimeStats() const;
+    MetadataTrafficStats getMetadataTrafficStats() const;
     AllocationMode getAllocationMode() const { return allocation_mode_; }
     void setAllocationMode(AllocationMode mode);
+    bool isBuddyExact() const { return buddy_exact_; }
+    void setBuddyExact(bool exact) { buddy_exact_ = exact; }
+
+    // Single-page buddy requests go through a per-process page cache.
+    // Changing the watermarks drains every cache; high 0 turns them off.
+    void setPageCacheWatermarks(size_t low, size_t high);
+    // Summed over all processes, including terminated ones.
+    PageCache::Stats getPageCacheStats() const;
     MemoryStats getBuddyAllocatorStats() const;
+    MemoryStats getSlabAllocatorStats() const;
+    vector<SlabAllocator::CacheInfo> getSlabCacheInfo() const;
     VirtualMemoryManager::VMMStats getVMMStats() const;
     void printMemoryBar() const;
 
     bool initialize();
+    // Same, with a new physical memory size (a multiple of the page size).
+    bool initialize(Size total_memory);
     bool isInitialized() const { return initialized_; }
 
     bool createProcess(ProcessId process_id);
     bool terminateProcess(ProcessId process_id);
 
-    AllocationResult allocateMemory(ProcessId process_id, Size size);
+    // alignment (a power of two, 0 = none) is honored by every back end;
+    // slab and arena requests that need more than 16 bytes go to the
+    // physical allocator instead. The lifetime hint only matters to the
+    // physical allocator's lifetime strategy.
+    AllocationResult allocateMemory(ProcessId process_id, Size size, Size alignment = 0,
+                                    LifetimeHint lifetime = LifetimeHint::UNKNOWN);
     bool deallocateMemory(ProcessId process_id, Address address);
+
+    // One process lookup and one back-end call per allocator for the whole
+    // batch; results are in request order.
+    vector<AllocationResult> allocateBatch(ProcessId process_id, const vector<Size> &sizes);
+    size_t deallocateBatch(ProcessId process_id, const vector<Address> &addresses);
+
+    // count buddy blocks of block_size (rounded up to a power of two),
+    // carved in bulk; returns the addresses obtained. Free them with
+    // deallocateBatch, which frees buddy blocks in bulk too.
+    vector<Address> allocateBulk(ProcessId process_id, Size block_size, size_t count);
+
+    // Resizes a live allocation. Physical and buddy blocks are resized in
+    // place when their allocator can; anything else moves (allocate, copy,
+    // free). On failure the old allocation is untouched.
+    AllocationResult reallocate(ProcessId process_id, Address address, Size new_size);
     bool accessMemory(ProcessId process_id, Address virtual_address, bool is_write = false);
 
     void switchAllocationStrategy(AllocationStrategy new_strategy);
+
+    // Turning tracing on resets its counters.
+    void setMetadataTracing(bool enabled);
+
+    // Moves at most max_bytes of physical blocks (0 = until fully packed)
+    // and rewrites process allocations to the new addresses.
+    vector<Relocation> compactHeap(Size max_bytes = 0);
+
+    // Runs one compaction step of step_bytes after a physical allocation or
+    // free whenever external fragmentation is above threshold (0..1).
+    // A threshold of 0 turns automatic compaction off.
+    void setAutoCompaction(double threshold, Size step_bytes);
+
+    // Current address of a block that was at `address` before any
+    // compaction step (the address itself if it never moved).
+    Address resolveRelocation(Address address) const;
     void switchPageReplacementPolicy(PageReplacementPolicy new_policy);
 
     void printMemoryDump() const;
@@ -73,6 +201,16 @@ public:
 
     void runMemoryTest(const string &test_name);
     void benchmarkAllocationStrategies();
+    void benchmarkAllocationScaling(size_t max_live_blocks = 16000);
+    void benchmarkFitScan(size_t max_live_blocks = 1000000);
+    void benchmarkAllocationLatency(size_t operations = 50000);
+    void benchmarkSmallObjects(size_t operations = 200000);
+    void benchmarkProcessTeardown(size_t max_objects = 32000);
+    void benchmarkConcurrentScaling(size_t max_threads = 0, bool buddy_backend = false);
+    void benchmarkBatchReplay(size_t phases = 200, size_t batch_size = 1000);
+    void benchmarkAlignment(size_t objects = 4096);
+    void benchmarkLifetimePlacement(size_t operations = 200000);
+    void benchmarkMetadataTraffic(size_t operations = 50000);
     void benchmarkCachePerformance();
 
     Size getTotalMemory() const { return total_memory_; }
@@ -82,6 +220,18 @@ public:
 
 private:
     unique_ptr<BaseAllocator> createAllocator(AllocationStrategy strategy, Size memory_size);
+    AllocationTarget selectTarget(Size size, Size alignment = 0) const;
+    void applyRelocations(const vector<Relocation> &relocations);
+    void recordMove(Address old_address, Address new_address);
+    // Drops every relocation entry through an address whose object was
+    // freed or that a new allocation has just reused.
+    void forgetRelocations(Address address);
+    void maybeCompact();
+    // Returns every process's cached free pages to the buddy allocator.
+    size_t drainPageCaches();
+    // Keeps the counters of a cache that is about to go away.
+    void retirePageCache(const PageCache &pages);
+    void attachMetadataObservers();
     void updateStatistics();
     Address translateVirtualToPhysical(ProcessId process_id, Address virtual_address);
 };
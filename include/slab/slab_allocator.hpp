@@ -0,0 +1,117 @@
+#ifndef SLAB_ALLOCATOR_HPP
+#define SLAB_ALLOCATOR_HPP
+
+#include <vector>
+#include <list>
+#include <functional>
+#include <unordered_map>
+#include <cstdint>
+
+#include "buddy/buddy_allocator.hpp"
+#include "common/types.hpp"
+
+using namespace std;
+
+// Object caches for small requests. Each size class carves whole slabs,
+// taken from the buddy allocator, into fixed-size objects and hands them
+// out from per-slab free lists. Slabs are kept on full, partial and empty
+// lists so an allocation never has to search for space.
+class SlabAllocator
+{
+public:
+    static constexpr Size MAX_OBJECT_SIZE = 1024;
+    // Every size class is a multiple of this, and slabs are page aligned.
+    static constexpr Size OBJECT_ALIGNMENT = 16;
+    // Most slabs a cache takes from the buddy allocator per refill, in
+    // one bulk call.
+    static constexpr size_t GROW_BATCH = 4;
+
+    struct CacheInfo
+    {
+        Size object_size;
+        size_t objects_per_slab;
+        size_t full_slabs;
+        size_t partial_slabs;
+        size_t empty_slabs;
+        size_t active_objects;
+    };
+
+private:
+    enum class SlabState
+    {
+        EMPTY,
+        PARTIAL,
+        FULL
+    };
+
+    struct Slab
+    {
+        int cache;
+        SlabState state;
+        list<Address>::iterator position;
+        vector<uint32_t> free_objects;
+        size_t in_use;
+    };
+
+    struct Cache
+    {
+        Size object_size;
+        size_t objects_per_slab;
+        list<Address> full;
+        list<Address> partial;
+        list<Address> empty;
+        size_t active_objects;
+    };
+
+    BuddyAllocator &buddy_;
+    Size slab_size_;
+
+    vector<Cache> caches_;
+    vector<int> class_for_units_;
+    unordered_map<Address, Slab> slabs_;
+    unordered_map<Address, pair<ProcessId, Size>> objects_;
+
+    size_t allocation_requests_;
+    size_t allocation_successes_;
+    size_t allocation_failures_;
+    Size internal_fragmentation_;
+
+    // Called when the buddy allocator has no page for a refill; returns
+    // how many pages it freed.
+    function<size_t()> reclaimer_;
+
+public:
+    SlabAllocator(BuddyAllocator &buddy, Size slab_size = 4096);
+    ~SlabAllocator() = default;
+
+    // Drops all slabs without returning them; used when the buddy
+    // allocator underneath has just been reset.
+    void initialize();
+
+    static bool handles(Size size) { return size > 0 && size <= MAX_OBJECT_SIZE; }
+
+    AllocationResult allocate(const AllocationRequest &request);
+    bool deallocate(Address address);
+
+    // Requested size of the live object at address, or 0 if there is none.
+    Size objectSize(Address address) const;
+
+    // Returns every empty slab to the buddy allocator.
+    size_t shrink();
+
+    void setReclaimer(function<size_t()> reclaimer) { reclaimer_ = move(reclaimer); }
+
+    MemoryStats getStats() const;
+    vector<CacheInfo> getCacheInfo() const;
+
+private:
+    // Adds empty slabs, as many as the cache already has but between 1
+    // and GROW_BATCH, so a busy cache refills in batches while an idle
+    // one holds a single page. If the buddy allocator is out of pages,
+    // the reclaimer runs once before giving up.
+    bool grow(int cache);
+    void moveSlab(Address base, Slab &slab, SlabState state);
+    list<Address> &slabList(Cache &cache, SlabState state);
+};
+
+#endif
@@ -30,6 +30,11 @@ private:
     Size page_size_;
     ProcessId process_id_;
 
+    // Present entries, and present entries with the dirty bit set; kept in
+    // step with every change to entries_.
+    size_t present_pages_;
+    size_t modified_pages_;
+
 public:
     PageTable(ProcessId process_id, Size page_size);
     void invalidateFrame(size_t frame_number);
@@ -47,8 +52,8 @@ public:
     ProcessId getProcessId() const { return process_id_; }
 
     size_t getNumPages() const { return entries_.size(); }
-    size_t getPresentPages() const;
-    size_t getModifiedPages() const;
+    size_t getPresentPages() const { return present_pages_; }
+    size_t getModifiedPages() const { return modified_pages_; }
 
     void clear();
 };
@@ -23,6 +23,7 @@ private:
     
 
     vector<bool> frame_allocation_;
+    size_t free_frames_;
     unordered_map<ProcessId, unique_ptr<PageTable>> process_tables_;
 
     PageReplacementPolicy replacement_policy_;
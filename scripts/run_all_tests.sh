@@ -24,4 +24,46 @@ echo "Running cache tests..."
 echo "Running VM tests..."
 "$BIN" < "$TESTS/vm_tests.txt" > "$RESULTS/vm_result.txt"
 
+echo "Running strategy tests..."
+"$BIN" < "$TESTS/strategy_tests.txt" > "$RESULTS/strategy_result.txt"
+
+echo "Running slab tests..."
+"$BIN" < "$TESTS/slab_tests.txt" > "$RESULTS/slab_result.txt"
+
+echo "Running arena tests..."
+"$BIN" < "$TESTS/arena_tests.txt" > "$RESULTS/arena_result.txt"
+
+echo "Running batch tests..."
+"$BIN" < "$TESTS/batch_tests.txt" > "$RESULTS/batch_result.txt"
+
+echo "Running compaction tests..."
+"$BIN" < "$TESTS/compaction_tests.txt" > "$RESULTS/compaction_result.txt"
+
+echo "Running realloc tests..."
+"$BIN" < "$TESTS/realloc_tests.txt" > "$RESULTS/realloc_result.txt"
+
+echo "Running alignment tests..."
+"$BIN" < "$TESTS/alignment_tests.txt" > "$RESULTS/alignment_result.txt"
+
+echo "Running ptmalloc tests..."
+"$BIN" < "$TESTS/ptmalloc_tests.txt" > "$RESULTS/ptmalloc_result.txt"
+
+echo "Running lifetime tests..."
+"$BIN" < "$TESTS/lifetime_tests.txt" > "$RESULTS/lifetime_result.txt"
+
+echo "Running metadata tests..."
+"$BIN" < "$TESTS/metadata_tests.txt" > "$RESULTS/metadata_result.txt"
+
+echo "Running large memory tests..."
+"$BIN" < "$TESTS/large_memory_tests.txt" > "$RESULTS/large_memory_result.txt"
+
+echo "Running exact buddy tests..."
+"$BIN" < "$TESTS/exact_tests.txt" > "$RESULTS/exact_result.txt"
+
+echo "Running bulk buddy tests..."
+"$BIN" < "$TESTS/bulk_tests.txt" > "$RESULTS/bulk_result.txt"
+
+echo "Running page cache tests..."
+"$BIN" < "$TESTS/pcp_tests.txt" > "$RESULTS/pcp_result.txt"
+
 echo "All tests completed successfully."
@@ -5,7 +5,20 @@
 
 BaseAllocator::BaseAllocator(Size total_memory)
     : total_memory_(total_memory),
-      next_block_id_(0)
+      next_block_id_(0),
+      allocation_requests_(0),
+      allocation_successes_(0),
+      allocation_failures_(0),
+      internal_fragmentation_(0),
+      blocks_scanned_(0),
+      longest_scan_(0),
+      realloc_in_place_(0),
+      realloc_moved_(0),
+      realloc_bytes_copied_(0),
+      aligned_allocations_(0),
+      alignment_waste_(0),
+      compact_cursor_(0),
+      free_bytes_(0)
 {
     stats_.total_memory = total_memory;
 }
@@ -14,15 +27,30 @@ void BaseAllocator::initialize(Size total_memory)
 {
     total_memory_ = total_memory;
     memory_blocks_.clear();
+    free_by_size_.clear();
+    free_bytes_ = 0;
+    block_index_.clear();
+    address_index_.clear();
     next_block_id_ = 0;
 
     allocation_requests_ = 0;
     allocation_successes_ = 0;
     allocation_failures_ = 0;
     internal_fragmentation_ = 0;
+    blocks_scanned_ = 0;
+    longest_scan_ = 0;
+    realloc_in_place_ = 0;
+    realloc_moved_ = 0;
+    realloc_bytes_copied_ = 0;
+    aligned_allocations_ = 0;
+    alignment_waste_ = 0;
+    compact_cursor_ = 0;
 
-    MemoryBlock initial_block(0, total_memory, BlockStatus::FREE, -1, generateBlockId());
+    MemoryBlock initial_block(0, total_memory, BlockStatus::FREE, -1, next_block_id_++);
     memory_blocks_.push_back(initial_block);
+    indexFreeBlock(memory_blocks_.begin());
+    block_index_[initial_block.block_id] = memory_blocks_.begin();
+    address_index_[0] = memory_blocks_.begin();
 }
 
 bool BaseAllocator::deallocate(BlockId block_id)
@@ -33,37 +61,151 @@ bool BaseAllocator::deallocate(BlockId block_id)
     if (it->status != BlockStatus::ALLOCATED)
         return false;
 
-    it->status = BlockStatus::FREE;
-    it->process_id = -1;
+    markFree(it);
 
-    coalesce();
+    coalesceNeighbors(it);
     return true;
 }
 
-MemoryStats BaseAllocator::getStats() const
+bool BaseAllocator::deallocateAddress(Address address, ProcessId process_id)
 {
-    MemoryStats stats;
+    auto it = findBlockByAddress(address);
+    if (it == memory_blocks_.end())
+        return false;
+    if (it->status != BlockStatus::ALLOCATED || it->process_id != process_id)
+        return false;
 
-    stats.total_memory = total_memory_;
+    return deallocate(it->block_id);
+}
+
+vector<AllocationResult> BaseAllocator::allocateBatch(const vector<Size> &sizes, ProcessId process_id)
+{
+    vector<AllocationResult> results;
+    results.reserve(sizes.size());
+    for (Size size : sizes)
+    {
+        results.push_back(allocate({size, process_id}));
+    }
+    return results;
+}
 
-    Size used = 0;
-    Size free_mem = 0;
-    Size largest_free = 0;
+size_t BaseAllocator::deallocateBatch(const vector<Address> &addresses, ProcessId process_id)
+{
+    // Release every block first without touching the free indexes...
+    vector<pair<Address, BlockIterator>> freed;
+    freed.reserve(addresses.size());
+    for (Address address : addresses)
+    {
+        auto it = findBlockByAddress(address);
+        if (it == memory_blocks_.end())
+            continue;
+        if (it->status != BlockStatus::ALLOCATED || it->process_id != process_id)
+            continue;
 
-    for (const auto &block : memory_blocks_)
+        it->status = BlockStatus::FREE;
+        it->process_id = -1;
+        it->alignment = 0;
+        touchHeader(address, true);
+        freed.emplace_back(address, it);
+    }
+    sort(freed.begin(), freed.end(),
+         [](const pair<Address, BlockIterator> &a, const pair<Address, BlockIterator> &b)
+         { return a.first < b.first; });
+
+    // ...then fold each run of adjacent free blocks into its first block and
+    // index the result once. Released blocks inside a run are consecutive in
+    // `freed`, and only the blocks that were free before the batch are in
+    // the indexes.
+    size_t i = 0;
+    while (i < freed.size())
     {
-        if (block.status == BlockStatus::ALLOCATED)
+        BlockIterator first = freed[i].second;
+        while (first != memory_blocks_.begin() && prev(first)->status == BlockStatus::FREE)
+            --first;
+
+        BlockIterator last = freed[i].second;
+        while (next(last) != memory_blocks_.end() && next(last)->status == BlockStatus::FREE)
+            ++last;
+
+        Size total = 0;
+        for (auto it = first;; ++it)
         {
-            used += block.size;
+            if (i < freed.size() && it == freed[i].second)
+                i++;
+            else
+                unindexFreeBlock(it);
+            total += it->size;
+            if (it == last)
+                break;
         }
-        else
+
+        for (auto it = next(first), stop = next(last); it != stop;)
         {
-            free_mem += block.size;
-            largest_free = max(largest_free, block.size);
+            block_index_.erase(it->block_id);
+            address_index_.erase(it->start_address);
+            it = memory_blocks_.erase(it);
         }
+
+        first->size = total;
+        touchHeader(first->start_address, true);
+        indexFreeBlock(first);
     }
 
-    stats.used_memory = used;
+    return freed.size();
+}
+
+AllocationResult BaseAllocator::reallocate(Address address, Size new_size, ProcessId process_id)
+{
+    Size old_size = allocationSize(address, process_id);
+    if (old_size == 0 || new_size == 0)
+        return AllocationResult(false, 0, -1);
+
+    auto resized = resizeInPlace(address, new_size, process_id);
+    if (resized.success)
+    {
+        realloc_in_place_++;
+        return resized;
+    }
+
+    // The old block stays live until the copy is done, as with realloc(3).
+    auto result = allocate(reallocationRequest(address, new_size, process_id));
+    if (!result.success)
+        return result;
+
+    realloc_moved_++;
+    realloc_bytes_copied_ += min(old_size, new_size);
+    deallocateAddress(address, process_id);
+    return result;
+}
+
+AllocationRequest BaseAllocator::reallocationRequest(Address address, Size new_size, ProcessId process_id) const
+{
+    auto it = address_index_.find(address);
+    Size alignment = it == address_index_.end() ? 0 : it->second->alignment;
+    return AllocationRequest(new_size, process_id, alignment);
+}
+
+Size BaseAllocator::allocationSize(Address address, ProcessId process_id) const
+{
+    auto it = address_index_.find(address);
+    if (it == address_index_.end())
+        return 0;
+    if (it->second->status != BlockStatus::ALLOCATED || it->second->process_id != process_id)
+        return 0;
+    return it->second->size;
+}
+
+MemoryStats BaseAllocator::getStats() const
+{
+    MemoryStats stats;
+
+    stats.total_memory = total_memory_;
+
+    // Blocks tile memory, so whatever is not indexed as free is in use.
+    Size free_mem = free_bytes_;
+    Size largest_free = free_by_size_.empty() ? 0 : free_by_size_.rbegin()->first.first;
+
+    stats.used_memory = total_memory_ - free_mem;
     stats.free_memory = free_mem;
     stats.largest_free_block = largest_free;
 
@@ -71,10 +213,17 @@ MemoryStats BaseAllocator::getStats() const
     stats.allocation_requests = allocation_requests_;
     stats.allocation_successes = allocation_successes_;
     stats.allocation_failures = allocation_failures_;
+    stats.blocks_scanned = blocks_scanned_;
+    stats.longest_scan = longest_scan_;
+    stats.realloc_in_place = realloc_in_place_;
+    stats.realloc_moved = realloc_moved_;
+    stats.realloc_bytes_copied = realloc_bytes_copied_;
+    stats.aligned_allocations = aligned_allocations_;
+    stats.alignment_waste = alignment_waste_;
 
     stats.total_blocks = memory_blocks_.size();
-    stats.allocated_blocks = allocation_successes_;
-    stats.free_blocks = stats.total_blocks - stats.allocated_blocks;
+    stats.free_blocks = free_by_size_.size();
+    stats.allocated_blocks = stats.total_blocks - stats.free_blocks;
 
     if (free_mem > 0)
     {
@@ -99,32 +248,44 @@ MemoryStats BaseAllocator::getStats() const
     return stats;
 }
 
-const vector<MemoryBlock> &BaseAllocator::getBlocks() const
+const BlockList &BaseAllocator::getBlocks() const
 {
     return memory_blocks_;
 }
 
+size_t BaseAllocator::getMetadataBytes() const
+{
+    // List node, id hash entry and address tree node for every block, plus
+    // a size-index node for every free block.
+    constexpr size_t tree_node = 3 * sizeof(void *) + sizeof(int);
+    constexpr size_t per_block =
+        sizeof(MemoryBlock) + 2 * sizeof(void *) +
+        sizeof(pair<const BlockId, BlockIterator>) + 2 * sizeof(void *) +
+        sizeof(pair<const Address, BlockIterator>) + tree_node;
+    constexpr size_t per_free_block =
+        sizeof(pair<const pair<Size, Address>, BlockIterator>) + tree_node;
+
+    return memory_blocks_.size() * per_block +
+           free_by_size_.size() * per_free_block +
+           block_index_.bucket_count() * sizeof(void *);
+}
+
 void BaseAllocator::coalesce()
 {
     if (memory_blocks_.size() < 2)
         return;
 
-    sort(memory_blocks_.begin(), memory_blocks_.end(),
-         [](const MemoryBlock &a, const MemoryBlock &b)
-         {
-             return a.start_address < b.start_address;
-         });
-
-    for (auto it = memory_blocks_.begin(); it != memory_blocks_.end() - 1;)
+    // The list is always in address order, so a single pass merges every
+    // run of adjacent free blocks without sorting.
+    for (auto it = memory_blocks_.begin(); next(it) != memory_blocks_.end();)
     {
-        auto next_it = it + 1;
+        auto next_it = next(it);
 
         if (it->status == BlockStatus::FREE &&
             next_it->status == BlockStatus::FREE &&
             it->start_address + it->size == next_it->start_address)
         {
-            it->size += next_it->size;
-            memory_blocks_.erase(next_it);
+            mergeBlocks(it, next_it);
         }
         else
         {
@@ -133,7 +294,154 @@ void BaseAllocator::coalesce()
     }
 }
 
-bool BaseAllocator::splitBlock(vector<MemoryBlock>::iterator block_it, Size requested_size)
+Size BaseAllocator::compactStep(Size max_bytes, vector<Relocation> &relocations)
+{
+    auto it = memory_blocks_.end();
+    auto pos = address_index_.lower_bound(compact_cursor_);
+    if (pos != address_index_.end())
+        it = pos->second;
+    while (it != memory_blocks_.end() && it->status == BlockStatus::ALLOCATED)
+        ++it;
+
+    Size moved = 0;
+    bool skipped = false;
+    Address first_hole = 0;
+    while (it != memory_blocks_.end())
+    {
+        // Neighbors of a free block are never free, so the next block (if
+        // any) is allocated and can slide down into this hole.
+        auto block = next(it);
+        if (block == memory_blocks_.end())
+            break;
+
+        // An aligned block only moves to an address that keeps its
+        // alignment; otherwise it stays put and the hole stays with it.
+        if (block->alignment > 1 && it->start_address % block->alignment != 0)
+        {
+            if (!skipped)
+                first_hole = it->start_address;
+            skipped = true;
+            for (it = next(block); it != memory_blocks_.end() && it->status == BlockStatus::ALLOCATED;)
+                ++it;
+            continue;
+        }
+        if (moved > 0 && moved + block->size > max_bytes)
+            break;
+
+        Address old_address = block->start_address;
+        Address new_address = it->start_address;
+
+        unindexFreeBlock(it);
+        address_index_.erase(old_address);
+        address_index_.erase(new_address);
+
+        block->start_address = new_address;
+        it->start_address = new_address + block->size;
+        memory_blocks_.splice(it, memory_blocks_, block);
+
+        address_index_[block->start_address] = block;
+        address_index_[it->start_address] = it;
+        touchHeader(block->start_address, true);
+        touchHeader(it->start_address, true);
+        indexFreeBlock(it);
+
+        relocations.push_back({old_address, new_address, block->size, block->process_id});
+        moved += block->size;
+
+        // The hole now sits in front of the next block; absorb it if free.
+        it = coalesceNeighbors(it);
+    }
+
+    if (skipped)
+        compact_cursor_ = first_hole;
+    else
+        compact_cursor_ = it == memory_blocks_.end() ? total_memory_ : it->start_address;
+    return moved;
+}
+
+AllocationResult BaseAllocator::resizeInPlace(Address address, Size new_size, ProcessId process_id)
+{
+    auto it = findBlockByAddress(address);
+    if (it == memory_blocks_.end() || it->status != BlockStatus::ALLOCATED ||
+        it->process_id != process_id)
+        return AllocationResult(false, 0, -1);
+
+    if (new_size == it->size)
+        return AllocationResult(true, address, it->block_id);
+
+    auto next_it = next(it);
+    if (new_size < it->size)
+    {
+        // Give the tail back as a free block and merge it with whatever
+        // free space follows.
+        Address tail_start = address + new_size;
+        MemoryBlock tail(tail_start, it->size - new_size, BlockStatus::FREE, -1, next_block_id_++);
+        it->size = new_size;
+        touchHeader(address, true);
+        touchHeader(tail_start, true);
+
+        auto tail_it = memory_blocks_.insert(next_it, tail);
+        indexFreeBlock(tail_it);
+        block_index_[tail_it->block_id] = tail_it;
+        address_index_[tail_start] = tail_it;
+        coalesceNeighbors(tail_it);
+        return AllocationResult(true, address, it->block_id);
+    }
+
+    // Growing needs enough free space directly after the block.
+    Size extra = new_size - it->size;
+    if (next_it == memory_blocks_.end() || next_it->status != BlockStatus::FREE ||
+        next_it->size < extra)
+        return AllocationResult(false, 0, -1);
+
+    touchHeader(next_it->start_address, false);
+    unindexFreeBlock(next_it);
+    if (next_it->size == extra)
+    {
+        block_index_.erase(next_it->block_id);
+        address_index_.erase(next_it->start_address);
+        memory_blocks_.erase(next_it);
+    }
+    else
+    {
+        address_index_.erase(next_it->start_address);
+        next_it->start_address += extra;
+        next_it->size -= extra;
+        address_index_[next_it->start_address] = next_it;
+        touchHeader(next_it->start_address, true);
+        indexFreeBlock(next_it);
+    }
+
+    it->size = new_size;
+    touchHeader(address, true);
+    return AllocationResult(true, address, it->block_id);
+}
+
+BlockIterator BaseAllocator::coalesceNeighbors(BlockIterator block_it)
+{
+    if (block_it != memory_blocks_.begin())
+    {
+        auto prev_it = prev(block_it);
+        touchHeader(prev_it->start_address, false);
+        if (prev_it->status == BlockStatus::FREE)
+        {
+            mergeBlocks(prev_it, block_it);
+            block_it = prev_it;
+        }
+    }
+
+    auto next_it = next(block_it);
+    if (next_it != memory_blocks_.end())
+        touchHeader(next_it->start_address, false);
+    if (next_it != memory_blocks_.end() && next_it->status == BlockStatus::FREE)
+    {
+        mergeBlocks(block_it, next_it);
+    }
+
+    return block_it;
+}
+
+bool BaseAllocator::splitBlock(BlockIterator block_it, Size requested_size)
 {
     if (block_it == memory_blocks_.end())
         return false;
@@ -152,14 +460,21 @@ bool BaseAllocator::splitBlock(vector<MemoryBlock>::iterator block_it, Size requ
         -1,
         next_block_id_++);
 
+    unindexFreeBlock(block_it);
     block_it->size = requested_size;
-    memory_blocks_.insert(block_it + 1, new_block);
+    touchHeader(block_it->start_address, true);
+    touchHeader(new_start, true);
+    indexFreeBlock(block_it);
+
+    auto new_it = memory_blocks_.insert(next(block_it), new_block);
+    indexFreeBlock(new_it);
+    block_index_[new_it->block_id] = new_it;
+    address_index_[new_start] = new_it;
 
     return true;
 }
 
-void BaseAllocator::mergeBlocks(vector<MemoryBlock>::iterator first,
-                                vector<MemoryBlock>::iterator second)
+void BaseAllocator::mergeBlocks(BlockIterator first, BlockIterator second)
 {
     if (first == memory_blocks_.end())
         return;
@@ -172,28 +487,128 @@ void BaseAllocator::mergeBlocks(vector<MemoryBlock>::iterator first,
     if (first->start_address + first->size != second->start_address)
         return;
 
+    unindexFreeBlock(first);
+    unindexFreeBlock(second);
     first->size += second->size;
+    touchHeader(second->start_address, false);
+    touchHeader(first->start_address, true);
+    indexFreeBlock(first);
+    block_index_.erase(second->block_id);
+    address_index_.erase(second->start_address);
     memory_blocks_.erase(second);
 }
 
-vector<MemoryBlock>::iterator BaseAllocator::findBlockById(BlockId id)
+BlockIterator BaseAllocator::findBlockById(BlockId id)
 {
-    return find_if(
-        memory_blocks_.begin(),
-        memory_blocks_.end(),
-        [id](const MemoryBlock &block)
-        {
-            return block.block_id == id;
-        });
+    auto it = block_index_.find(id);
+    return it != block_index_.end() ? it->second : memory_blocks_.end();
 }
 
-vector<MemoryBlock>::const_iterator BaseAllocator::findBlockById(BlockId id) const
+BlockList::const_iterator BaseAllocator::findBlockById(BlockId id) const
 {
-    return find_if(
-        memory_blocks_.cbegin(),
-        memory_blocks_.cend(),
-        [id](const MemoryBlock &block)
-        {
-            return block.block_id == id;
-        });
+    auto it = block_index_.find(id);
+    return it != block_index_.end() ? BlockList::const_iterator(it->second)
+                                    : memory_blocks_.cend();
+}
+
+BlockIterator BaseAllocator::findBlockByAddress(Address address)
+{
+    auto it = address_index_.find(address);
+    return it != address_index_.end() ? it->second : memory_blocks_.end();
+}
+
+void BaseAllocator::markAllocated(BlockIterator block_it, ProcessId process_id, Size alignment)
+{
+    if (block_it->status == BlockStatus::FREE)
+        unindexFreeBlock(block_it);
+
+    block_it->status = BlockStatus::ALLOCATED;
+    block_it->process_id = process_id;
+    block_it->alignment = alignment > 1 ? alignment : 0;
+    touchHeader(block_it->start_address, true);
+}
+
+void BaseAllocator::markFree(BlockIterator block_it)
+{
+    if (block_it->status != BlockStatus::FREE)
+        indexFreeBlock(block_it);
+
+    block_it->status = BlockStatus::FREE;
+    block_it->process_id = -1;
+    block_it->alignment = 0;
+    touchHeader(block_it->start_address, true);
+}
+
+void BaseAllocator::recordScan(size_t blocks)
+{
+    blocks_scanned_ += blocks;
+    longest_scan_ = max(longest_scan_, blocks);
+}
+
+Size BaseAllocator::searchSize(const AllocationRequest &request) const
+{
+    if (request.size == 0)
+        return 0;
+    if (request.alignment <= 1)
+        return request.size;
+    if (!isPowerOfTwo(request.alignment) || request.alignment > total_memory_ ||
+        request.size > total_memory_ - (request.alignment - 1))
+        return 0;
+
+    // Worst case the block starts one byte past a boundary.
+    return request.size + request.alignment - 1;
+}
+
+BlockIterator BaseAllocator::alignBlock(BlockIterator block_it, Size alignment)
+{
+    if (alignment <= 1)
+        return block_it;
+
+    aligned_allocations_++;
+    Size padding = alignUp(block_it->start_address, alignment) - block_it->start_address;
+    if (padding == 0)
+        return block_it;
+
+    alignment_waste_ += padding;
+    splitBlock(block_it, padding);
+    return next(block_it);
+}
+
+void BaseAllocator::indexFreeBlock(BlockIterator block_it)
+{
+    if (block_it->start_address < compact_cursor_)
+        compact_cursor_ = block_it->start_address;
+
+    free_by_size_[{block_it->size, block_it->start_address}] = block_it;
+    free_bytes_ += block_it->size;
+    touchLink(block_it->start_address, true);
+}
+
+void BaseAllocator::unindexFreeBlock(BlockIterator block_it)
+{
+    if (free_by_size_.erase({block_it->size, block_it->start_address}))
+        free_bytes_ -= block_it->size;
+    touchLink(block_it->start_address, false);
+}
+
+void BaseAllocator::setMetadataObserver(MetadataObserver observer)
+{
+    metadata_observer_ = move(observer);
+}
+
+void BaseAllocator::touchSizeIndexPath(map<pair<Size, Address>, BlockIterator>::const_iterator found) const
+{
+    if (!metadata_observer_ || free_by_size_.empty())
+        return;
+
+    if (found == free_by_size_.end())
+        --found;
+    size_t depth = log2Floor(static_cast<Size>(free_by_size_.size())) + 1;
+    for (size_t i = 0; i < depth; ++i)
+    {
+        touchHeader(found->second->start_address, false);
+        if (found == free_by_size_.begin())
+            break;
+        --found;
+    }
 }
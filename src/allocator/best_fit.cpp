@@ -1,6 +1,5 @@
 #include "allocator/best_fit.hpp"
 #include <algorithm>
-#include <limits>
 
 BestFitAllocator::BestFitAllocator(Size total_memory)
     : BaseAllocator(total_memory)
@@ -11,48 +10,38 @@ AllocationResult BestFitAllocator::allocate(const AllocationRequest &request)
 {
     allocation_requests_++;
 
-    if (request.size == 0)
+    Size search_size = searchSize(request);
+    if (search_size == 0)
     {
         allocation_failures_++;
         return AllocationResult(false, 0, -1);
     }
 
-    auto block_it = findFreeBlock(request.size);
+    auto block_it = findFreeBlock(search_size);
     if (block_it == memory_blocks_.end())
     {
         allocation_failures_++;
         return AllocationResult(false, 0, -1);
     }
-    Address alloc_address = block_it->start_address;
-    BlockId alloc_block_id = block_it->block_id;
+    block_it = alignBlock(block_it, request.alignment);
     if (block_it->size > request.size)
     {
         splitBlock(block_it, request.size);
-        block_it = findBlockById(alloc_block_id);
     }
 
-    block_it->status = BlockStatus::ALLOCATED;
-    block_it->process_id = request.process_id;
+    markAllocated(block_it, request.process_id, request.alignment);
     allocation_successes_++;
     return AllocationResult(true, block_it->start_address, block_it->block_id);
 }
 
-vector<MemoryBlock>::iterator BestFitAllocator::findFreeBlock(Size size)
+BlockIterator BestFitAllocator::findFreeBlock(Size size)
 {
-    vector<MemoryBlock>::iterator best_fit = memory_blocks_.end();
-    Size smallest_size = numeric_limits<Size>::max();
-
-    for (auto it = memory_blocks_.begin(); it != memory_blocks_.end(); ++it)
-    {
-        if (it->status == BlockStatus::FREE && it->size >= size)
-        {
-            if (it->size < smallest_size)
-            {
-                smallest_size = it->size;
-                best_fit = it;
-            }
-        }
-    }
-
-    return best_fit;
+    // Smallest free block that fits; ties go to the lowest address.
+    auto best_fit = free_by_size_.lower_bound({size, 0});
+    touchSizeIndexPath(best_fit);
+    if (best_fit == free_by_size_.end())
+        return memory_blocks_.end();
+
+    recordScan(1);
+    return best_fit->second;
 }
@@ -0,0 +1,669 @@
+#include "allocator/bitmap_allocator.hpp"
+#include "common/utils.hpp"
+#include <algorithm>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+enum class WordGroup {
+    ALL_ALLOCATED,
+    ALL_FREE,
+    MIXED
+};
+
+// Classifies GROUP_WORDS consecutive bitmap words in one go, so long fully
+// used or fully free stretches are skipped without touching single bits.
+#if defined(__AVX2__)
+constexpr size_t GROUP_WORDS = 4;
+
+inline WordGroup classifyGroup(const uint64_t* words) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(words));
+    if (_mm256_testz_si256(v, v)) {
+        return WordGroup::ALL_FREE;
+    }
+    if (_mm256_testc_si256(v, _mm256_set1_epi32(-1))) {
+        return WordGroup::ALL_ALLOCATED;
+    }
+    return WordGroup::MIXED;
+}
+#elif defined(__SSE2__) || defined(_M_X64)
+constexpr size_t GROUP_WORDS = 2;
+
+inline WordGroup classifyGroup(const uint64_t* words) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(words));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128())) == 0xFFFF) {
+        return WordGroup::ALL_FREE;
+    }
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(-1))) == 0xFFFF) {
+        return WordGroup::ALL_ALLOCATED;
+    }
+    return WordGroup::MIXED;
+}
+#else
+constexpr size_t GROUP_WORDS = 1;
+
+inline WordGroup classifyGroup(const uint64_t* words) {
+    if (*words == 0) {
+        return WordGroup::ALL_FREE;
+    }
+    if (*words == ~0ull) {
+        return WordGroup::ALL_ALLOCATED;
+    }
+    return WordGroup::MIXED;
+}
+#endif
+
+}
+
+BitmapAllocator::BitmapAllocator(Size total_memory, Size unit_size)
+    : BaseAllocator(total_memory),
+      unit_size_(unit_size),
+      num_units_(0),
+      allocated_units_(0) {
+}
+
+void BitmapAllocator::initialize(Size total_memory) {
+    total_memory_ = total_memory;
+    memory_blocks_.clear();
+    free_by_size_.clear();
+    free_bytes_ = 0;
+    block_index_.clear();
+    address_index_.clear();
+    next_block_id_ = 0;
+
+    allocation_requests_ = 0;
+    allocation_successes_ = 0;
+    allocation_failures_ = 0;
+    internal_fragmentation_ = 0;
+    blocks_scanned_ = 0;
+    longest_scan_ = 0;
+    realloc_in_place_ = 0;
+    realloc_moved_ = 0;
+    realloc_bytes_copied_ = 0;
+    aligned_allocations_ = 0;
+    alignment_waste_ = 0;
+
+    // A trailing partial unit is never handed out.
+    num_units_ = total_memory / unit_size_;
+    allocated_units_ = 0;
+    allocations_.clear();
+    search_hint_.assign(MAX_HINT_UNITS + 1, 0);
+    free_runs_.clear();
+    run_lengths_.clear();
+    if (num_units_ > 0) {
+        addFreeRun(0, num_units_);
+    }
+
+    size_t words = (num_units_ + 63) / 64;
+    words = (words + GROUP_WORDS - 1) / GROUP_WORDS * GROUP_WORDS;
+    bitmap_.assign(words, 0);
+
+    // Bits past the last unit (and any group padding) read as allocated.
+    for (size_t unit = num_units_; unit < words * 64; ++unit) {
+        bitmap_[unit / 64] |= 1ull << (unit % 64);
+    }
+}
+
+AllocationResult BitmapAllocator::allocate(const AllocationRequest& request) {
+    allocation_requests_++;
+    if (request.size == 0 || (request.alignment > 1 && !isPowerOfTwo(request.alignment))) {
+        allocation_failures_++;
+        return AllocationResult(false, 0, -1);
+    }
+
+    // Units are already unit_size-aligned; larger alignments search for
+    // enough slack to skip up to the next boundary.
+    size_t units = (static_cast<size_t>(request.size) + unit_size_ - 1) / unit_size_;
+    size_t align_units = request.alignment > unit_size_ ? request.alignment / unit_size_ : 1;
+    size_t search_units = units + align_units - 1;
+
+    size_t& hint = search_hint_[min(search_units, MAX_HINT_UNITS)];
+    touchHints(min(search_units, MAX_HINT_UNITS), 1, false);
+    size_t first = findFreeRun(search_units, hint);
+
+    // The first run that fits is consumed, so the next search for this
+    // size can start past it. Larger requests share a bucket and only
+    // read the hint, as do aligned ones, which leave padding behind.
+    if (search_units <= MAX_HINT_UNITS && align_units == 1) {
+        hint = first == NPOS ? num_units_ : first + units;
+        touchHints(search_units, 1, true);
+    }
+
+    if (first == NPOS) {
+        allocation_failures_++;
+        return AllocationResult(false, 0, -1);
+    }
+
+    if (request.alignment > 1) {
+        size_t aligned = (first + align_units - 1) / align_units * align_units;
+        aligned_allocations_++;
+        alignment_waste_ += static_cast<Size>((aligned - first) * unit_size_);
+        first = aligned;
+    }
+
+    setRange(first, units, true);
+    allocated_units_ += units;
+    allocations_[first] = {units, align_units, request.size, request.process_id};
+    touchRecord(first, true);
+    internal_fragmentation_ += static_cast<Size>(units * unit_size_ - request.size);
+
+    allocation_successes_++;
+    return AllocationResult(true, static_cast<Address>(first * unit_size_), static_cast<BlockId>(first));
+}
+
+bool BitmapAllocator::deallocate(BlockId block_id) {
+    auto it = allocations_.find(static_cast<size_t>(block_id));
+    if (block_id < 0 || it == allocations_.end()) {
+        return false;
+    }
+
+    const Allocation& a = it->second;
+    touchRecord(it->first, false);
+    setRange(it->first, a.units, false);
+
+    // The freed units join a run starting at or before them.
+    size_t run_start = freeRunStart(it->first);
+    for (auto& hint : search_hint_) {
+        hint = min(hint, run_start);
+    }
+    touchHints(0, search_hint_.size(), true);
+    touchRecord(it->first, true);
+    allocated_units_ -= a.units;
+    internal_fragmentation_ -= static_cast<Size>(a.units * unit_size_ - a.requested_size);
+
+    allocations_.erase(it);
+    return true;
+}
+
+bool BitmapAllocator::deallocateAddress(Address address, ProcessId process_id) {
+    if (address % unit_size_ != 0) {
+        return false;
+    }
+
+    auto it = allocations_.find(address / unit_size_);
+    if (it == allocations_.end() || it->second.process_id != process_id) {
+        return false;
+    }
+
+    return deallocate(static_cast<BlockId>(it->first));
+}
+
+size_t BitmapAllocator::deallocateBatch(const vector<Address>& addresses, ProcessId process_id) {
+    size_t freed = 0;
+    size_t lowest = num_units_;
+    for (Address address : addresses) {
+        if (address % unit_size_ != 0) {
+            continue;
+        }
+        auto it = allocations_.find(address / unit_size_);
+        if (it == allocations_.end() || it->second.process_id != process_id) {
+            continue;
+        }
+
+        const Allocation& a = it->second;
+        touchRecord(it->first, false);
+        setRange(it->first, a.units, false);
+        touchRecord(it->first, true);
+        allocated_units_ -= a.units;
+        internal_fragmentation_ -= static_cast<Size>(a.units * unit_size_ - a.requested_size);
+        lowest = min(lowest, it->first);
+        allocations_.erase(it);
+        freed++;
+    }
+
+    // Every new run starts at or after the run holding the lowest freed
+    // unit, so the hints are lowered once for the whole batch.
+    if (freed > 0) {
+        size_t run_start = freeRunStart(lowest);
+        for (auto& hint : search_hint_) {
+            hint = min(hint, run_start);
+        }
+        touchHints(0, search_hint_.size(), true);
+    }
+    return freed;
+}
+
+Size BitmapAllocator::allocationSize(Address address, ProcessId process_id) const {
+    if (address % unit_size_ != 0) {
+        return 0;
+    }
+    auto it = allocations_.find(address / unit_size_);
+    if (it == allocations_.end() || it->second.process_id != process_id) {
+        return 0;
+    }
+    return it->second.requested_size;
+}
+
+AllocationRequest BitmapAllocator::reallocationRequest(Address address, Size new_size, ProcessId process_id) const {
+    // Every unit is unit_size-aligned, so only larger alignments are kept.
+    auto it = allocations_.find(address / unit_size_);
+    Size alignment = it == allocations_.end() || it->second.align_units == 1
+                         ? 0
+                         : static_cast<Size>(it->second.align_units * unit_size_);
+    return AllocationRequest(new_size, process_id, alignment);
+}
+
+AllocationResult BitmapAllocator::resizeInPlace(Address address, Size new_size, ProcessId process_id) {
+    if (address % unit_size_ != 0) {
+        return AllocationResult(false, 0, -1);
+    }
+    size_t first = address / unit_size_;
+    auto it = allocations_.find(first);
+    if (it == allocations_.end() || it->second.process_id != process_id) {
+        return AllocationResult(false, 0, -1);
+    }
+
+    Allocation& a = it->second;
+    size_t units = (static_cast<size_t>(new_size) + unit_size_ - 1) / unit_size_;
+    touchRecord(first, false);
+
+    if (units > a.units) {
+        if (first + units > num_units_ || nextAllocated(first + a.units) < first + units) {
+            return AllocationResult(false, 0, -1);
+        }
+        // Taking free units never opens a run, so the hints stay valid.
+        setRange(first + a.units, units - a.units, true);
+    } else if (units < a.units) {
+        setRange(first + units, a.units - units, false);
+        for (auto& hint : search_hint_) {
+            hint = min(hint, first + units);
+        }
+        touchHints(0, search_hint_.size(), true);
+    }
+    touchRecord(first, true);
+
+    allocated_units_ = allocated_units_ - a.units + units;
+    internal_fragmentation_ -= static_cast<Size>(a.units * unit_size_ - a.requested_size);
+    internal_fragmentation_ += static_cast<Size>(units * unit_size_ - new_size);
+    a.units = units;
+    a.requested_size = new_size;
+
+    return AllocationResult(true, address, static_cast<BlockId>(first));
+}
+
+Size BitmapAllocator::compactStep(Size max_bytes, vector<Relocation>& relocations) {
+    // No unit below search_hint_[1] is free, so the packed prefix is skipped.
+    size_t hole = nextFree(search_hint_[1]);
+    size_t first_hole = NPOS;
+    Size moved = 0;
+
+    while (hole < num_units_) {
+        size_t first = nextAllocated(hole);
+        if (first >= num_units_) {
+            break;
+        }
+
+        auto it = allocations_.find(first);
+        Allocation a = it->second;
+
+        // Aligned allocations stay put unless the hole keeps their alignment.
+        if (hole % a.align_units != 0) {
+            first_hole = min(first_hole, hole);
+            hole = nextFree(first + a.units);
+            continue;
+        }
+
+        Size bytes = static_cast<Size>(a.units * unit_size_);
+        if (moved > 0 && moved + bytes > max_bytes) {
+            break;
+        }
+
+        setRange(first, a.units, false);
+        setRange(hole, a.units, true);
+        allocations_.erase(it);
+        allocations_[hole] = a;
+
+        relocations.push_back({static_cast<Address>(first * unit_size_),
+                               static_cast<Address>(hole * unit_size_),
+                               bytes, a.process_id});
+        moved += bytes;
+        hole = nextFree(hole + a.units);
+    }
+
+    // Everything below the first hole left behind is packed, so no run
+    // starts before it.
+    hole = min(hole, first_hole);
+    for (auto& hint : search_hint_) {
+        hint = min(hint, hole);
+    }
+    return moved;
+}
+
+MemoryStats BitmapAllocator::getStats() const {
+    MemoryStats stats;
+    stats.total_memory = total_memory_;
+    stats.used_memory = static_cast<Size>(allocated_units_ * unit_size_);
+    stats.free_memory = total_memory_ - stats.used_memory;
+
+    size_t free_runs = free_runs_.size();
+    Size largest_free = run_lengths_.empty() ? 0 : static_cast<Size>(*run_lengths_.rbegin() * unit_size_);
+
+    stats.largest_free_block = largest_free;
+    stats.internal_fragmentation = internal_fragmentation_;
+    stats.allocation_requests = allocation_requests_;
+    stats.allocation_successes = allocation_successes_;
+    stats.allocation_failures = allocation_failures_;
+    stats.blocks_scanned = blocks_scanned_;
+    stats.longest_scan = longest_scan_;
+    stats.realloc_in_place = realloc_in_place_;
+    stats.realloc_moved = realloc_moved_;
+    stats.realloc_bytes_copied = realloc_bytes_copied_;
+    stats.aligned_allocations = aligned_allocations_;
+    stats.alignment_waste = alignment_waste_;
+
+    stats.allocated_blocks = allocations_.size();
+    stats.free_blocks = free_runs;
+    stats.total_blocks = stats.allocated_blocks + stats.free_blocks;
+
+    stats.fragmentation_ratio = stats.free_memory > 0
+        ? 1.0 - static_cast<double>(largest_free) / stats.free_memory
+        : 0.0;
+    stats.memory_utilization = total_memory_ > 0
+        ? static_cast<double>(stats.used_memory) / total_memory_
+        : 0.0;
+
+    return stats;
+}
+
+const BlockList& BitmapAllocator::getBlocks() const {
+    // Rebuilt on demand for dumps; the allocator itself never walks blocks.
+    snapshot_.clear();
+
+    size_t unit = 0;
+    while (unit < num_units_) {
+        if (isAllocated(unit)) {
+            auto it = allocations_.find(unit);
+            size_t units = it != allocations_.end() ? it->second.units : 1;
+            ProcessId pid = it != allocations_.end() ? it->second.process_id : -1;
+
+            snapshot_.emplace_back(
+                static_cast<Address>(unit * unit_size_),
+                static_cast<Size>(units * unit_size_),
+                BlockStatus::ALLOCATED,
+                pid,
+                static_cast<BlockId>(unit));
+            unit += units;
+        } else {
+            size_t end = min(nextAllocated(unit), num_units_);
+            snapshot_.emplace_back(
+                static_cast<Address>(unit * unit_size_),
+                static_cast<Size>((end - unit) * unit_size_),
+                BlockStatus::FREE,
+                -1,
+                -1);
+            unit = end;
+        }
+    }
+
+    return snapshot_;
+}
+
+size_t BitmapAllocator::getMetadataBytes() const {
+    size_t per_allocation = sizeof(size_t) + sizeof(Allocation) + 2 * sizeof(void*);
+    return bitmap_.size() * sizeof(uint64_t)
+         + allocations_.size() * per_allocation
+         + allocations_.bucket_count() * sizeof(void*);
+}
+
+BlockIterator BitmapAllocator::findFreeBlock(Size) {
+    // There is no block list to point into; allocate() searches the
+    // bitmap through findFreeRun instead.
+    return memory_blocks_.end();
+}
+
+size_t BitmapAllocator::findFreeRun(size_t units, size_t from_unit) {
+    size_t run = 0;
+    size_t run_start = 0;
+    size_t scanned = 1;
+    const size_t words = bitmap_.size();
+
+    if (from_unit >= num_units_) {
+        recordScan(0);
+        return NPOS;
+    }
+
+    // Units below from_unit in its word are treated as allocated.
+    size_t w = from_unit / 64;
+    uint64_t below = (1ull << (from_unit % 64)) - 1;
+    touchWords(w, 1, false);
+    if (scanWord(bitmap_[w] | below, w * 64, units, run, run_start)) {
+        recordScan(scanned);
+        return run_start;
+    }
+    w++;
+
+    while (w < words) {
+        scanned++;
+
+        if (w + GROUP_WORDS <= words) {
+            touchWords(w, GROUP_WORDS, false);
+            WordGroup group = classifyGroup(&bitmap_[w]);
+            if (group == WordGroup::ALL_ALLOCATED) {
+                run = 0;
+                w += GROUP_WORDS;
+                continue;
+            }
+            if (group == WordGroup::ALL_FREE) {
+                if (run == 0) {
+                    run_start = w * 64;
+                }
+                run += GROUP_WORDS * 64;
+                if (run >= units) {
+                    recordScan(scanned);
+                    return run_start;
+                }
+                w += GROUP_WORDS;
+                continue;
+            }
+        }
+
+        touchWords(w, 1, false);
+        if (scanWord(bitmap_[w], w * 64, units, run, run_start)) {
+            recordScan(scanned);
+            return run_start;
+        }
+        w++;
+    }
+
+    recordScan(scanned);
+    return NPOS;
+}
+
+bool BitmapAllocator::scanWord(uint64_t word, size_t base, size_t units,
+                               size_t& run, size_t& run_start) const {
+    if (word == 0) {
+        if (run == 0) {
+            run_start = base;
+        }
+        run += 64;
+        return run >= units;
+    }
+
+    // A run carried in from lower words continues through the low free bits.
+    size_t low_free = findFirstSet64(word);
+    if (run + low_free >= units) {
+        if (run == 0) {
+            run_start = base;
+        }
+        return true;
+    }
+
+    // Runs inside the word: after the shift-and-AND steps, bit i survives
+    // only if units i .. i+units-1 are all free.
+    if (units < 64) {
+        uint64_t fits = ~word;
+        size_t len = 1;
+        while (len < units) {
+            size_t step = min(len, units - len);
+            fits &= fits >> step;
+            len += step;
+        }
+        if (fits != 0) {
+            run_start = base + findFirstSet64(fits);
+            return true;
+        }
+    }
+
+    // Only the free bits at the top of the word carry into the next one.
+    size_t high_free = 63 - findLastSet64(word);
+    run = high_free;
+    run_start = base + 64 - high_free;
+    return false;
+}
+
+void BitmapAllocator::setRange(size_t first, size_t count, bool allocated) {
+    size_t unit = first;
+    size_t end = first + count;
+    if (count > 0) {
+        touchWords(first / 64, (end - 1) / 64 - first / 64 + 1, true);
+    }
+
+    while (unit < end) {
+        size_t bit = unit % 64;
+        size_t span = min<size_t>(64 - bit, end - unit);
+        uint64_t mask = span == 64 ? ~0ull : ((1ull << span) - 1) << bit;
+
+        if (allocated) {
+            bitmap_[unit / 64] |= mask;
+        } else {
+            bitmap_[unit / 64] &= ~mask;
+        }
+        unit += span;
+    }
+
+    if (count > 0) {
+        if (allocated) {
+            takeFromFreeRun(first, count);
+        } else {
+            addFreeRun(first, count);
+        }
+    }
+}
+
+void BitmapAllocator::addFreeRun(size_t first, size_t count) {
+    size_t end = first + count;
+    auto next = free_runs_.lower_bound(first);
+    if (next != free_runs_.begin()) {
+        auto prev_run = prev(next);
+        if (prev_run->first + prev_run->second == first) {
+            first = prev_run->first;
+            run_lengths_.erase(run_lengths_.find(prev_run->second));
+            free_runs_.erase(prev_run);
+        }
+    }
+    if (next != free_runs_.end() && next->first == end) {
+        end += next->second;
+        run_lengths_.erase(run_lengths_.find(next->second));
+        free_runs_.erase(next);
+    }
+
+    free_runs_[first] = end - first;
+    run_lengths_.insert(end - first);
+}
+
+void BitmapAllocator::takeFromFreeRun(size_t first, size_t count) {
+    auto run = prev(free_runs_.upper_bound(first));
+    size_t start = run->first;
+    size_t end = start + run->second;
+    run_lengths_.erase(run_lengths_.find(run->second));
+    free_runs_.erase(run);
+
+    if (first > start) {
+        free_runs_[start] = first - start;
+        run_lengths_.insert(first - start);
+    }
+    if (first + count < end) {
+        free_runs_[first + count] = end - first - count;
+        run_lengths_.insert(end - first - count);
+    }
+}
+
+bool BitmapAllocator::isAllocated(size_t unit) const {
+    return (bitmap_[unit / 64] >> (unit % 64)) & 1ull;
+}
+
+size_t BitmapAllocator::freeRunStart(size_t unit) const {
+    size_t w = unit / 64;
+    size_t bit = unit % 64;
+    uint64_t word = bit == 0 ? 0 : bitmap_[w] & ((1ull << bit) - 1);
+
+    while (word == 0) {
+        if (w == 0) {
+            return 0;
+        }
+        word = bitmap_[--w];
+        touchWords(w, 1, false);
+    }
+
+    // One past the highest allocated unit below `unit`.
+    return w * 64 + findLastSet64(word) + 1;
+}
+
+size_t BitmapAllocator::nextFree(size_t unit) const {
+    size_t w = unit / 64;
+    if (w >= bitmap_.size()) {
+        return bitmap_.size() * 64;
+    }
+    uint64_t word = ~bitmap_[w] & (~0ull << (unit % 64));
+    touchWords(w, 1, false);
+
+    while (word == 0) {
+        if (++w == bitmap_.size()) {
+            return bitmap_.size() * 64;
+        }
+        word = ~bitmap_[w];
+        touchWords(w, 1, false);
+    }
+    return w * 64 + findFirstSet64(word);
+}
+
+size_t BitmapAllocator::nextAllocated(size_t unit) const {
+    size_t w = unit / 64;
+    uint64_t word = bitmap_[w] & (~0ull << (unit % 64));
+    touchWords(w, 1, false);
+
+    while (word == 0) {
+        if (++w == bitmap_.size()) {
+            return bitmap_.size() * 64;
+        }
+        word = bitmap_[w];
+        touchWords(w, 1, false);
+    }
+    return w * 64 + findFirstSet64(word);
+}
+
+void BitmapAllocator::touchWords(size_t first_word, size_t count, bool is_write) const {
+    if (!metadata_observer_) {
+        return;
+    }
+    for (size_t line = first_word / 8; line <= (first_word + count - 1) / 8; ++line) {
+        touchMetadata(line * 64, is_write);
+    }
+}
+
+void BitmapAllocator::touchHints(size_t first, size_t count, bool is_write) const {
+    if (!metadata_observer_) {
+        return;
+    }
+    size_t base = alignUp(static_cast<Address>(bitmap_.size() * sizeof(uint64_t)), 64);
+    for (size_t line = first / 8; line <= (first + count - 1) / 8; ++line) {
+        touchMetadata(base + line * 64, is_write);
+    }
+}
+
+void BitmapAllocator::touchRecord(size_t first_unit, bool is_write) const {
+    if (!metadata_observer_) {
+        return;
+    }
+    size_t base = alignUp(static_cast<Address>(bitmap_.size() * sizeof(uint64_t)), 64) +
+                  alignUp(static_cast<Address>(search_hint_.size() * sizeof(size_t)), 64);
+    // Room for one live allocation per 4 units, hashed Fibonacci-style.
+    size_t slots = max<size_t>(num_units_ / 4, 1);
+    size_t slot = (first_unit * 11400714819323198485ull) % slots;
+    touchMetadata(base + slot * 16, is_write);
+}
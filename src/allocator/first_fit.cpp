@@ -5,39 +5,64 @@ FirstFitAllocator::FirstFitAllocator(Size total_memory)
     : BaseAllocator(total_memory) {
 }
 
+void FirstFitAllocator::initialize(Size total_memory) {
+    free_tree_.clear();
+    BaseAllocator::initialize(total_memory);
+}
+
+void FirstFitAllocator::setMetadataObserver(MetadataObserver observer) {
+    BaseAllocator::setMetadataObserver(observer);
+    if (observer) {
+        // The tree lives in the out-of-band metadata region.
+        free_tree_.setObserver([this](Address offset, bool is_write) { touchMetadata(offset, is_write); });
+    } else {
+        free_tree_.setObserver(nullptr);
+    }
+}
+
 AllocationResult FirstFitAllocator::allocate(const AllocationRequest& request) {
     allocation_requests_++;
-    if (request.size == 0) {
+    Size search_size = searchSize(request);
+    if (search_size == 0) {
         allocation_failures_++;
         return AllocationResult(false, 0, -1);
     }
 
-    auto block_it = findFreeBlock(request.size);
+    auto block_it = findFreeBlock(search_size);
     if (block_it == memory_blocks_.end()) {
         allocation_failures_++;
         return AllocationResult(false, 0, -1);
     }
+    block_it = alignBlock(block_it, request.alignment);
 
     Address alloc_address = block_it->start_address;
     BlockId alloc_block_id = block_it->block_id;
     if (block_it->size > request.size) {
         splitBlock(block_it, request.size);
-        block_it = findBlockById(alloc_block_id);
     }
 
-    block_it->status = BlockStatus::ALLOCATED;
-    block_it->process_id = request.process_id;
+    markAllocated(block_it, request.process_id, request.alignment);
 
     allocation_successes_++;
     return AllocationResult(true, alloc_address, alloc_block_id);
 }
 
-vector<MemoryBlock>::iterator FirstFitAllocator::findFreeBlock(Size size) {
-    return find_if(
-        memory_blocks_.begin(),
-        memory_blocks_.end(),
-        [size](const MemoryBlock& block) {
-            return block.status == BlockStatus::FREE && block.size >= size;
-        }
-    );
+BlockIterator FirstFitAllocator::findFreeBlock(Size size) {
+    // Lowest-address free block that fits, same as a linear scan.
+    BlockIterator block_it;
+    size_t nodes_visited = 0;
+    bool found = free_tree_.findFirstFit(size, block_it, nodes_visited);
+    recordScan(nodes_visited);
+
+    return found ? block_it : memory_blocks_.end();
+}
+
+void FirstFitAllocator::indexFreeBlock(BlockIterator block_it) {
+    BaseAllocator::indexFreeBlock(block_it);
+    free_tree_.insert(block_it);
+}
+
+void FirstFitAllocator::unindexFreeBlock(BlockIterator block_it) {
+    BaseAllocator::unindexFreeBlock(block_it);
+    free_tree_.erase(block_it->start_address);
 }
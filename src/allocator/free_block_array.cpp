@@ -0,0 +1,298 @@
+#include "allocator/free_block_array.hpp"
+#include "common/utils.hpp"
+#include <algorithm>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+FreeBlockArray::FreeBlockArray()
+    : count_(0) {
+}
+
+void FreeBlockArray::clear() {
+    chunks_.clear();
+    count_ = 0;
+}
+
+void FreeBlockArray::insert(BlockIterator block) {
+    Address address = block->start_address;
+    if (chunks_.empty()) {
+        chunks_.push_back(Chunk{{address}, {block->size}, {block}, block->size});
+        count_++;
+        return;
+    }
+
+    // Below every chunk: it goes at the front of the first one.
+    size_t index = chunkFor(address);
+    if (index == chunks_.size()) {
+        index = 0;
+    }
+    Chunk& chunk = chunks_[index];
+
+    size_t pos = lower_bound(chunk.starts.begin(), chunk.starts.end(), address) - chunk.starts.begin();
+    if (observer_) {
+        for (Array array : {STARTS, SIZES, BLOCKS}) {
+            touchEntries(index, array, pos, chunk.starts.size() + 1, true);
+        }
+        touchDirectory(index, true);
+    }
+    chunk.starts.insert(chunk.starts.begin() + pos, address);
+    chunk.sizes.insert(chunk.sizes.begin() + pos, block->size);
+    chunk.blocks.insert(chunk.blocks.begin() + pos, block);
+    chunk.max_size = max(chunk.max_size, block->size);
+    count_++;
+
+    if (chunk.starts.size() > CHUNK_CAPACITY) {
+        splitChunk(index);
+    }
+}
+
+void FreeBlockArray::erase(Address address) {
+    size_t index = chunkFor(address);
+    if (index == chunks_.size()) {
+        return;
+    }
+    Chunk& chunk = chunks_[index];
+
+    auto it = lower_bound(chunk.starts.begin(), chunk.starts.end(), address);
+    if (it == chunk.starts.end() || *it != address) {
+        return;
+    }
+    size_t pos = it - chunk.starts.begin();
+    Size size = chunk.sizes[pos];
+    if (observer_) {
+        for (Array array : {STARTS, SIZES, BLOCKS}) {
+            touchEntries(index, array, pos, chunk.starts.size(), true);
+        }
+    }
+
+    chunk.starts.erase(chunk.starts.begin() + pos);
+    chunk.sizes.erase(chunk.sizes.begin() + pos);
+    chunk.blocks.erase(chunk.blocks.begin() + pos);
+    count_--;
+
+    if (chunk.starts.empty()) {
+        removeChunk(index);
+        return;
+    }
+    if (size == chunk.max_size) {
+        refreshMax(chunk);
+        touchEntries(index, SIZES, 0, chunk.sizes.size(), false);
+        touchDirectory(index, true);
+    }
+
+    // Fold a nearly empty chunk into its successor so frees do not leave
+    // a long tail of tiny chunks behind.
+    if (index + 1 < chunks_.size() &&
+        chunk.starts.size() + chunks_[index + 1].starts.size() <= CHUNK_CAPACITY / 2) {
+        Chunk& next = chunks_[index + 1];
+        if (observer_) {
+            for (Array array : {STARTS, SIZES, BLOCKS}) {
+                touchEntries(index + 1, array, 0, next.starts.size(), false);
+                touchEntries(index, array, chunk.starts.size(), chunk.starts.size() + next.starts.size(), true);
+            }
+        }
+        chunk.starts.insert(chunk.starts.end(), next.starts.begin(), next.starts.end());
+        chunk.sizes.insert(chunk.sizes.end(), next.sizes.begin(), next.sizes.end());
+        chunk.blocks.insert(chunk.blocks.end(), next.blocks.begin(), next.blocks.end());
+        chunk.max_size = max(chunk.max_size, next.max_size);
+        removeChunk(index + 1);
+    }
+}
+
+bool FreeBlockArray::findNextFit(Size size, Address from, BlockIterator& out, size_t& entries_scanned) const {
+    entries_scanned = 0;
+    if (chunks_.empty()) {
+        return false;
+    }
+
+    size_t first_chunk = chunkFor(from);
+    size_t first_pos = 0;
+    if (first_chunk == chunks_.size()) {
+        first_chunk = 0;
+    } else {
+        // Start at the free block holding `from` if there is one: a freed
+        // block merged with the remainder the rover sits in starts below it.
+        const Chunk& chunk = chunks_[first_chunk];
+        first_pos = (upper_bound(chunk.starts.begin(), chunk.starts.end(), from) - chunk.starts.begin()) - 1;
+        if (chunk.starts[first_pos] + chunk.sizes[first_pos] <= from) {
+            first_pos++;
+        }
+    }
+
+    // From `from` to the top of memory...
+    size_t pos = first_pos;
+    for (size_t c = first_chunk; c < chunks_.size(); ++c, pos = 0) {
+        const Chunk& chunk = chunks_[c];
+        touchDirectory(c, false);
+        entries_scanned++;
+        if (chunk.max_size < size) {
+            continue;
+        }
+        size_t hit = scanChunk(chunk, pos, size);
+        entries_scanned += hit - pos;
+        touchEntries(c, SIZES, pos, min(hit + 1, chunk.sizes.size()), false);
+        if (hit < chunk.sizes.size()) {
+            touchEntries(c, BLOCKS, hit, hit + 1, false);
+            out = chunk.blocks[hit];
+            return true;
+        }
+    }
+
+    // ...then from the bottom up to where the search started.
+    for (size_t c = 0; c <= first_chunk; ++c) {
+        const Chunk& chunk = chunks_[c];
+        size_t end = c == first_chunk ? first_pos : chunk.sizes.size();
+        touchDirectory(c, false);
+        entries_scanned++;
+        if (chunk.max_size < size) {
+            continue;
+        }
+        size_t hit = scanChunk(chunk, 0, size);
+        entries_scanned += min(hit, end);
+        touchEntries(c, SIZES, 0, min(hit + 1, end), false);
+        if (hit < end) {
+            touchEntries(c, BLOCKS, hit, hit + 1, false);
+            out = chunk.blocks[hit];
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t FreeBlockArray::getMetadataBytes() const {
+    size_t bytes = chunks_.capacity() * sizeof(Chunk);
+    for (const auto& chunk : chunks_) {
+        bytes += chunk.starts.capacity() * sizeof(Address) +
+                 chunk.sizes.capacity() * sizeof(Size) +
+                 chunk.blocks.capacity() * sizeof(BlockIterator);
+    }
+    return bytes;
+}
+
+size_t FreeBlockArray::chunkFor(Address address) const {
+    // Last chunk starting at or below the address.
+    auto it = upper_bound(chunks_.begin(), chunks_.end(), address,
+                          [this](Address a, const Chunk& c) {
+                              touchDirectory(&c - chunks_.data(), false);
+                              return a < c.starts.front();
+                          });
+    return it == chunks_.begin() ? chunks_.size() : (it - chunks_.begin()) - 1;
+}
+
+void FreeBlockArray::splitChunk(size_t index) {
+    Chunk upper;
+    {
+        Chunk& lower = chunks_[index];
+        size_t half = lower.starts.size() / 2;
+        upper.starts.assign(lower.starts.begin() + half, lower.starts.end());
+        upper.sizes.assign(lower.sizes.begin() + half, lower.sizes.end());
+        upper.blocks.assign(lower.blocks.begin() + half, lower.blocks.end());
+        lower.starts.resize(half);
+        lower.sizes.resize(half);
+        lower.blocks.resize(half);
+        refreshMax(lower);
+        refreshMax(upper);
+    }
+    chunks_.insert(chunks_.begin() + index + 1, move(upper));
+
+    if (observer_) {
+        for (Array array : {STARTS, SIZES, BLOCKS}) {
+            touchEntries(index + 1, array, 0, chunks_[index + 1].starts.size(), true);
+        }
+        for (size_t c = index; c < chunks_.size(); ++c) {
+            touchDirectory(c, true);
+        }
+    }
+}
+
+void FreeBlockArray::removeChunk(size_t index) {
+    chunks_.erase(chunks_.begin() + index);
+    if (observer_) {
+        for (size_t c = index; c < chunks_.size(); ++c) {
+            touchDirectory(c, true);
+        }
+    }
+}
+
+void FreeBlockArray::touchDirectory(size_t chunk, bool is_write) const {
+    if (observer_) {
+        observer_(static_cast<Address>(chunk * DIRECTORY_ENTRY), is_write);
+    }
+}
+
+void FreeBlockArray::touchEntries(size_t chunk, Array array, size_t from, size_t to, bool is_write) const {
+    if (!observer_ || from >= to) {
+        return;
+    }
+
+    static constexpr size_t ENTRY_BYTES[] = {sizeof(Address), sizeof(Size), sizeof(BlockIterator)};
+    size_t slab = DIRECTORY_BYTES +
+                  chunk * (CHUNK_CAPACITY + 1) * (ENTRY_BYTES[STARTS] + ENTRY_BYTES[SIZES] + ENTRY_BYTES[BLOCKS]);
+    size_t base = slab;
+    for (int a = STARTS; a < array; ++a) {
+        base += (CHUNK_CAPACITY + 1) * ENTRY_BYTES[a];
+    }
+
+    size_t first_line = (base + from * ENTRY_BYTES[array]) / 64;
+    size_t last_line = (base + to * ENTRY_BYTES[array] - 1) / 64;
+    for (size_t line = first_line; line <= last_line; ++line) {
+        observer_(static_cast<Address>(line * 64), is_write);
+    }
+}
+
+void FreeBlockArray::refreshMax(Chunk& chunk) {
+    chunk.max_size = chunk.sizes.empty() ? 0 : *max_element(chunk.sizes.begin(), chunk.sizes.end());
+}
+
+size_t FreeBlockArray::scanChunk(const Chunk& chunk, size_t from, Size size) {
+    const Size* sizes = chunk.sizes.data();
+    size_t n = chunk.sizes.size();
+    size_t i = from;
+    if (size == 0) {
+        return i;
+    }
+
+    // Unsigned a >= b is signed (a ^ bias) > ((b - 1) ^ bias).
+    static_assert(sizeof(Size) == 8, "vector compare assumes 64-bit sizes");
+#if defined(__AVX2__)
+    const __m256i bias = _mm256_set1_epi64x(INT64_MIN);
+    const __m256i needle = _mm256_xor_si256(_mm256_set1_epi64x(static_cast<long long>(size - 1)), bias);
+    for (; i + 4 <= n; i += 4) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sizes + i));
+        int mask = _mm256_movemask_pd(_mm256_castsi256_pd(
+            _mm256_cmpgt_epi64(_mm256_xor_si256(v, bias), needle)));
+        if (mask) {
+            return i + findFirstSet(static_cast<uint32_t>(mask));
+        }
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    // SSE2 has no 64-bit compare: biasing each 32-bit half makes both
+    // halves compare unsigned, and a lane is greater if its high half is,
+    // or if the high halves match and its low half is.
+    const __m128i bias = _mm_set1_epi32(INT32_MIN);
+    const __m128i needle = _mm_xor_si128(_mm_set1_epi64x(static_cast<long long>(size - 1)), bias);
+    for (; i + 2 <= n; i += 2) {
+        __m128i v = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(sizes + i)), bias);
+        __m128i gt = _mm_cmpgt_epi32(v, needle);
+        __m128i eq = _mm_cmpeq_epi32(v, needle);
+        __m128i wide = _mm_or_si128(_mm_shuffle_epi32(gt, _MM_SHUFFLE(3, 3, 1, 1)),
+                                    _mm_and_si128(_mm_shuffle_epi32(eq, _MM_SHUFFLE(3, 3, 1, 1)),
+                                                  _mm_shuffle_epi32(gt, _MM_SHUFFLE(2, 2, 0, 0))));
+        int mask = _mm_movemask_pd(_mm_castsi128_pd(wide));
+        if (mask) {
+            return i + findFirstSet(static_cast<uint32_t>(mask));
+        }
+    }
+#endif
+
+    for (; i < n; ++i) {
+        if (sizes[i] >= size) {
+            return i;
+        }
+    }
+    return n;
+}
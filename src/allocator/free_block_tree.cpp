@@ -0,0 +1,166 @@
+#include "allocator/free_block_tree.hpp"
+#include <algorithm>
+
+FreeBlockTree::FreeBlockTree()
+    : root_(-1), seed_(2463534242u) {
+}
+
+void FreeBlockTree::clear() {
+    nodes_.clear();
+    free_nodes_.clear();
+    root_ = -1;
+}
+
+void FreeBlockTree::insert(BlockIterator block) {
+    int node = newNode(block);
+
+    int left = -1;
+    int right = -1;
+    split(root_, block->start_address, left, right);
+    root_ = merge(merge(left, node), right);
+}
+
+void FreeBlockTree::erase(Address address) {
+    root_ = eraseFrom(root_, address);
+}
+
+bool FreeBlockTree::findFirstFit(Size size, BlockIterator& out, size_t& nodes_visited) const {
+    int cur = root_;
+    nodes_visited = 0;
+    if (maxSize(cur) < size) {
+        return false;
+    }
+
+    while (cur >= 0) {
+        const Node& n = nodes_[cur];
+        touch(cur, false);
+        nodes_visited++;
+        if (maxSize(n.left) >= size) {
+            cur = n.left;
+        } else if (n.size >= size) {
+            out = n.block;
+            return true;
+        } else {
+            cur = n.right;
+        }
+    }
+    return false;
+}
+
+bool FreeBlockTree::findLastFit(Size size, BlockIterator& out, size_t& nodes_visited) const {
+    int cur = root_;
+    nodes_visited = 0;
+    if (maxSize(cur) < size) {
+        return false;
+    }
+
+    while (cur >= 0) {
+        const Node& n = nodes_[cur];
+        touch(cur, false);
+        nodes_visited++;
+        if (maxSize(n.right) >= size) {
+            cur = n.right;
+        } else if (n.size >= size) {
+            out = n.block;
+            return true;
+        } else {
+            cur = n.left;
+        }
+    }
+    return false;
+}
+
+int FreeBlockTree::newNode(BlockIterator block) {
+    Node n{block->start_address, block->size, block->size, nextPriority(), -1, -1, block};
+
+    if (!free_nodes_.empty()) {
+        int index = free_nodes_.back();
+        free_nodes_.pop_back();
+        nodes_[index] = n;
+        touch(index, true);
+        return index;
+    }
+
+    nodes_.push_back(n);
+    touch(static_cast<int>(nodes_.size()) - 1, true);
+    return static_cast<int>(nodes_.size()) - 1;
+}
+
+void FreeBlockTree::update(int node) {
+    Node& n = nodes_[node];
+    n.max_size = max({n.size, maxSize(n.left), maxSize(n.right)});
+    touch(node, true);
+}
+
+Size FreeBlockTree::maxSize(int node) const {
+    return node < 0 ? 0 : nodes_[node].max_size;
+}
+
+void FreeBlockTree::touch(int node, bool is_write) const {
+    if (observer_ && node >= 0) {
+        observer_(static_cast<Address>(node * sizeof(Node)), is_write);
+    }
+}
+
+void FreeBlockTree::split(int node, Address address, int& left, int& right) {
+    if (node < 0) {
+        left = right = -1;
+        return;
+    }
+
+    touch(node, false);
+    if (nodes_[node].address < address) {
+        split(nodes_[node].right, address, nodes_[node].right, right);
+        left = node;
+    } else {
+        split(nodes_[node].left, address, left, nodes_[node].left);
+        right = node;
+    }
+    update(node);
+}
+
+int FreeBlockTree::eraseFrom(int node, Address address) {
+    if (node < 0) {
+        return -1;
+    }
+
+    Node& n = nodes_[node];
+    touch(node, false);
+    if (address < n.address) {
+        n.left = eraseFrom(n.left, address);
+    } else if (address > n.address) {
+        n.right = eraseFrom(n.right, address);
+    } else {
+        free_nodes_.push_back(node);
+        return merge(n.left, n.right);
+    }
+
+    // Refresh max_size on the way back up.
+    update(node);
+    return node;
+}
+
+int FreeBlockTree::merge(int left, int right) {
+    if (left < 0) return right;
+    if (right < 0) return left;
+
+    touch(left, false);
+    touch(right, false);
+    if (nodes_[left].priority > nodes_[right].priority) {
+        nodes_[left].right = merge(nodes_[left].right, right);
+        update(left);
+        return left;
+    }
+
+    nodes_[right].left = merge(left, nodes_[right].left);
+    update(right);
+    return right;
+}
+
+uint32_t FreeBlockTree::nextPriority() {
+    // xorshift32: deterministic, so runs are reproducible.
+    seed_ ^= seed_ << 13;
+    seed_ ^= seed_ >> 17;
+    seed_ ^= seed_ << 5;
+    return seed_;
+}
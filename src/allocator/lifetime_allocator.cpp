@@ -0,0 +1,225 @@
+#include "allocator/lifetime_allocator.hpp"
+#include "common/utils.hpp"
+
+LifetimeAllocator::LifetimeAllocator(Size total_memory)
+    : BaseAllocator(total_memory),
+      clock_(0),
+      hinted_(0),
+      predicted_short_(0),
+      predicted_long_(0),
+      predictions_checked_(0),
+      predictions_correct_(0),
+      short_placements_(0) {
+}
+
+void LifetimeAllocator::initialize(Size total_memory) {
+    free_tree_.clear();
+    clock_ = 0;
+    live_.clear();
+    young_.clear();
+    history_.clear();
+    hinted_ = 0;
+    predicted_short_ = 0;
+    predicted_long_ = 0;
+    predictions_checked_ = 0;
+    predictions_correct_ = 0;
+    short_placements_ = 0;
+
+    BaseAllocator::initialize(total_memory);
+}
+
+void LifetimeAllocator::setMetadataObserver(MetadataObserver observer) {
+    BaseAllocator::setMetadataObserver(observer);
+    if (observer) {
+        free_tree_.setObserver([this](Address offset, bool is_write) { touchMetadata(offset, is_write); });
+    } else {
+        free_tree_.setObserver(nullptr);
+    }
+}
+
+AllocationResult LifetimeAllocator::allocate(const AllocationRequest& request) {
+    allocation_requests_++;
+    clock_++;
+    ageObjects();
+
+    Size search_size = searchSize(request);
+    if (search_size == 0) {
+        allocation_failures_++;
+        return AllocationResult(false, 0, -1);
+    }
+
+    uint64_t key = historyKey(request.process_id, request.size);
+    bool predicted = request.lifetime == LifetimeHint::UNKNOWN;
+    bool short_lived = predicted ? predictShort(key) : request.lifetime == LifetimeHint::SHORT;
+    if (!predicted) {
+        hinted_++;
+    } else if (short_lived) {
+        predicted_short_++;
+    } else {
+        predicted_long_++;
+    }
+
+    // Aligned requests always go bottom-up, where alignBlock handles them.
+    BlockIterator block_it = memory_blocks_.end();
+    if (short_lived && request.alignment <= 1) {
+        size_t nodes_visited = 0;
+        bool found = free_tree_.findLastFit(request.size, block_it, nodes_visited);
+        recordScan(nodes_visited);
+        if (!found) {
+            allocation_failures_++;
+            return AllocationResult(false, 0, -1);
+        }
+
+        // Carve from the end, so the rest of the block stays below it.
+        if (block_it->size > request.size) {
+            splitBlock(block_it, block_it->size - request.size);
+            block_it = next(block_it);
+        }
+        short_placements_++;
+    } else {
+        block_it = findFreeBlock(search_size);
+        if (block_it == memory_blocks_.end()) {
+            allocation_failures_++;
+            return AllocationResult(false, 0, -1);
+        }
+        block_it = alignBlock(block_it, request.alignment);
+
+        if (block_it->size > request.size) {
+            splitBlock(block_it, request.size);
+        }
+    }
+
+    markAllocated(block_it, request.process_id, request.alignment);
+    live_[block_it->block_id] = LiveObject{clock_, key, predicted, short_lived, false};
+    young_.emplace_back(clock_, block_it->block_id);
+
+    allocation_successes_++;
+    return AllocationResult(true, block_it->start_address, block_it->block_id);
+}
+
+bool LifetimeAllocator::deallocate(BlockId block_id) {
+    if (!BaseAllocator::deallocate(block_id)) {
+        return false;
+    }
+    recordDeath(block_id);
+    return true;
+}
+
+size_t LifetimeAllocator::deallocateBatch(const vector<Address>& addresses, ProcessId process_id) {
+    vector<BlockId> dying;
+    for (Address address : addresses) {
+        auto it = findBlockByAddress(address);
+        if (it != memory_blocks_.end() && it->status == BlockStatus::ALLOCATED &&
+            it->process_id == process_id) {
+            dying.push_back(it->block_id);
+        }
+    }
+
+    size_t freed = BaseAllocator::deallocateBatch(addresses, process_id);
+    for (BlockId block_id : dying) {
+        recordDeath(block_id);
+    }
+    return freed;
+}
+
+size_t LifetimeAllocator::getMetadataBytes() const {
+    return BaseAllocator::getMetadataBytes() +
+           live_.size() * (sizeof(pair<const BlockId, LiveObject>) + sizeof(void*)) +
+           live_.bucket_count() * sizeof(void*) +
+           history_.size() * (sizeof(pair<const uint64_t, History>) + sizeof(void*)) +
+           history_.bucket_count() * sizeof(void*) +
+           young_.size() * sizeof(pair<uint64_t, BlockId>);
+}
+
+BlockIterator LifetimeAllocator::findFreeBlock(Size size) {
+    BlockIterator block_it;
+    size_t nodes_visited = 0;
+    bool found = free_tree_.findFirstFit(size, block_it, nodes_visited);
+    recordScan(nodes_visited);
+
+    return found ? block_it : memory_blocks_.end();
+}
+
+AllocationRequest LifetimeAllocator::reallocationRequest(Address address, Size new_size, ProcessId process_id) const {
+    AllocationRequest request = BaseAllocator::reallocationRequest(address, new_size, process_id);
+    auto block = address_index_.find(address);
+    if (block != address_index_.end()) {
+        auto it = live_.find(block->second->block_id);
+        if (it != live_.end() && !it->second.predicted) {
+            request.lifetime = it->second.short_lived ? LifetimeHint::SHORT : LifetimeHint::LONG;
+        }
+    }
+    return request;
+}
+
+LifetimeAllocator::LifetimeStats LifetimeAllocator::getLifetimeStats() const {
+    return LifetimeStats{hinted_, predicted_short_, predicted_long_,
+                         predictions_checked_, predictions_correct_, short_placements_};
+}
+
+void LifetimeAllocator::indexFreeBlock(BlockIterator block_it) {
+    BaseAllocator::indexFreeBlock(block_it);
+    free_tree_.insert(block_it);
+}
+
+void LifetimeAllocator::unindexFreeBlock(BlockIterator block_it) {
+    BaseAllocator::unindexFreeBlock(block_it);
+    free_tree_.erase(block_it->start_address);
+}
+
+bool LifetimeAllocator::predictShort(uint64_t key) const {
+    // With no history a request is treated as long-lived: plain first fit.
+    auto it = history_.find(key);
+    return it != history_.end() && it->second.short_deaths > it->second.long_deaths;
+}
+
+void LifetimeAllocator::recordDeath(BlockId block_id) {
+    auto it = live_.find(block_id);
+    if (it == live_.end()) {
+        return;
+    }
+    if (!it->second.aged) {
+        learn(it->second, true);
+    }
+    live_.erase(it);
+}
+
+void LifetimeAllocator::ageObjects() {
+    while (!young_.empty() && clock_ - young_.front().first >= SHORT_LIFETIME) {
+        // Block ids are reused once a block is freed, so the birth time
+        // tells whether the entry is still the same object.
+        uint64_t born = young_.front().first;
+        auto it = live_.find(young_.front().second);
+        young_.pop_front();
+        if (it != live_.end() && it->second.born == born) {
+            learn(it->second, false);
+            it->second.aged = true;
+        }
+    }
+}
+
+void LifetimeAllocator::learn(LiveObject& object, bool died_young) {
+    if (object.predicted) {
+        predictions_checked_++;
+        if (object.short_lived == died_young) {
+            predictions_correct_++;
+        }
+    }
+
+    History& history = history_[object.key];
+    if (died_young) {
+        history.short_deaths++;
+    } else {
+        history.long_deaths++;
+    }
+    if (history.short_deaths + history.long_deaths > HISTORY_WINDOW) {
+        history.short_deaths /= 2;
+        history.long_deaths /= 2;
+    }
+}
+
+uint64_t LifetimeAllocator::historyKey(ProcessId process_id, Size size) {
+    // 16-byte classes up to 1 KB, then one class per power of two.
+    uint64_t size_class = size <= 1024 ? (size + 15) / 16 : 64 + log2Floor(size);
+    return (uint64_t(static_cast<uint32_t>(process_id)) << 32) | size_class;
+}
@@ -0,0 +1,72 @@
+#include "allocator/next_fit.hpp"
+#include <algorithm>
+
+NextFitAllocator::NextFitAllocator(Size total_memory)
+    : BaseAllocator(total_memory), rover_(0) {
+}
+
+void NextFitAllocator::initialize(Size total_memory) {
+    rover_ = 0;
+    free_array_.clear();
+    BaseAllocator::initialize(total_memory);
+}
+
+void NextFitAllocator::setMetadataObserver(MetadataObserver observer) {
+    BaseAllocator::setMetadataObserver(observer);
+    if (observer) {
+        free_array_.setObserver([this](Address offset, bool is_write) { touchMetadata(offset, is_write); });
+    } else {
+        free_array_.setObserver(nullptr);
+    }
+}
+
+AllocationResult NextFitAllocator::allocate(const AllocationRequest& request) {
+    allocation_requests_++;
+    Size search_size = searchSize(request);
+    if (search_size == 0) {
+        allocation_failures_++;
+        return AllocationResult(false, 0, -1);
+    }
+
+    auto block_it = findFreeBlock(search_size);
+    if (block_it == memory_blocks_.end()) {
+        allocation_failures_++;
+        return AllocationResult(false, 0, -1);
+    }
+    block_it = alignBlock(block_it, request.alignment);
+
+    if (block_it->size > request.size) {
+        splitBlock(block_it, request.size);
+    }
+
+    markAllocated(block_it, request.process_id, request.alignment);
+    rover_ = block_it->start_address + block_it->size;
+
+    allocation_successes_++;
+    return AllocationResult(true, block_it->start_address, block_it->block_id);
+}
+
+BlockIterator NextFitAllocator::findFreeBlock(Size size) {
+    // Same order as walking the block list from the rover and wrapping
+    // once, but only over free blocks.
+    BlockIterator block_it;
+    size_t scanned = 0;
+    bool found = free_array_.findNextFit(size, rover_, block_it, scanned);
+    recordScan(scanned);
+
+    return found ? block_it : memory_blocks_.end();
+}
+
+size_t NextFitAllocator::getMetadataBytes() const {
+    return BaseAllocator::getMetadataBytes() + free_array_.getMetadataBytes();
+}
+
+void NextFitAllocator::indexFreeBlock(BlockIterator block_it) {
+    BaseAllocator::indexFreeBlock(block_it);
+    free_array_.insert(block_it);
+}
+
+void NextFitAllocator::unindexFreeBlock(BlockIterator block_it) {
+    BaseAllocator::unindexFreeBlock(block_it);
+    free_array_.erase(block_it->start_address);
+}
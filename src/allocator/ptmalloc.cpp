@@ -0,0 +1,542 @@
+#include "allocator/ptmalloc.hpp"
+#include "common/utils.hpp"
+#include <algorithm>
+
+namespace {
+constexpr Size MAX_TCACHE_CHUNK =
+    PtmallocAllocator::MIN_CHUNK + (PtmallocAllocator::TCACHE_BINS - 1) * PtmallocAllocator::CHUNK_ALIGN;
+constexpr size_t FASTBIN_COUNT = PtmallocAllocator::MAX_FAST / PtmallocAllocator::CHUNK_ALIGN - 1;
+}
+
+PtmallocAllocator::PtmallocAllocator(Size total_memory)
+    : BaseAllocator(total_memory),
+      tcache_(TCACHE_BINS),
+      fastbins_(FASTBIN_COUNT),
+      cached_bytes_(0),
+      bins_(NBINS),
+      binmap_{},
+      has_top_(false),
+      brk_(0),
+      lookups_{},
+      hits_{},
+      fast_path_(0),
+      consolidations_(0),
+      top_extensions_(0) {
+}
+
+void PtmallocAllocator::initialize(Size total_memory) {
+    for (auto& slot : tcache_) {
+        slot.clear();
+    }
+    for (auto& bin : fastbins_) {
+        bin.clear();
+    }
+    cached_.clear();
+    cached_bytes_ = 0;
+    for (auto& bin : bins_) {
+        bin.clear();
+    }
+    bin_pos_.clear();
+    fill(begin(binmap_), end(binmap_), 0u);
+    has_top_ = false;
+    brk_ = 0;
+
+    fill(begin(lookups_), end(lookups_), size_t(0));
+    fill(begin(hits_), end(hits_), size_t(0));
+    fast_path_ = 0;
+    consolidations_ = 0;
+    top_extensions_ = 0;
+
+    BaseAllocator::initialize(total_memory);
+}
+
+AllocationResult PtmallocAllocator::allocate(const AllocationRequest& request) {
+    allocation_requests_++;
+    Size search_size = searchSize(request);
+    if (search_size == 0 || request.size > total_memory_ - min(total_memory_, CHUNK_HEADER + CHUNK_ALIGN)) {
+        allocation_failures_++;
+        return AllocationResult(false, 0, -1);
+    }
+
+    // Chunks are always 16-byte aligned, so only larger alignments need
+    // padding and skip the exact-size caches.
+    Size chunk_size = chunkSize(request.size);
+    bool aligned = request.alignment > CHUNK_ALIGN;
+    if (aligned) {
+        if (chunk_size > total_memory_ - (request.alignment - 1)) {
+            allocation_failures_++;
+            return AllocationResult(false, 0, -1);
+        }
+        search_size = chunk_size + request.alignment - 1;
+    } else {
+        search_size = chunk_size;
+    }
+
+    auto block_it = aligned ? memory_blocks_.end() : takeCached(chunk_size);
+    if (block_it == memory_blocks_.end()) {
+        // A large request first merges the fastbins, as malloc_consolidate
+        // does, so their chunks can serve it.
+        if (chunk_size >= MIN_LARGE && haveFastChunks()) {
+            consolidate(false);
+        }
+
+        block_it = findFreeBlock(search_size);
+        if (block_it == memory_blocks_.end() && consolidate(true) > 0) {
+            block_it = findFreeBlock(search_size);
+        }
+        if (block_it == memory_blocks_.end()) {
+            allocation_failures_++;
+            return AllocationResult(false, 0, -1);
+        }
+        block_it = alignBlock(block_it, request.alignment);
+
+        // A remainder too small to be a chunk stays with the allocation.
+        if (block_it->size >= chunk_size + MIN_CHUNK) {
+            splitBlock(block_it, chunk_size);
+        }
+        extendTop(block_it->start_address + block_it->size);
+    }
+
+    markAllocated(block_it, request.process_id, request.alignment);
+    block_it->requested_size = request.size;
+    internal_fragmentation_ += block_it->size - request.size;
+
+    allocation_successes_++;
+    return AllocationResult(true, block_it->start_address, block_it->block_id);
+}
+
+bool PtmallocAllocator::deallocate(BlockId block_id) {
+    auto it = findBlockById(block_id);
+    if (it == memory_blocks_.end() || it->status != BlockStatus::ALLOCATED ||
+        cached_.count(it->start_address)) {
+        return false;
+    }
+
+    internal_fragmentation_ -= it->size - it->requested_size;
+    it->process_id = -1;
+    it->alignment = 0;
+    touchHeader(it->start_address, false);
+
+    // Pushing onto a cache links the chunk to the old head.
+    if (it->size <= MAX_TCACHE_CHUNK) {
+        auto& slot = tcache_[tcacheIndex(it->size)];
+        touchTcache(tcacheIndex(it->size), false);
+        if (slot.size() < TCACHE_COUNT) {
+            cacheChunk(slot, it);
+            touchLink(it->start_address, true);
+            touchTcache(tcacheIndex(it->size), true);
+            return true;
+        }
+    }
+    if (it->size <= MAX_FAST) {
+        cacheChunk(fastbins_[fastbinIndex(it->size)], it);
+        touchFastbin(fastbinIndex(it->size), false);
+        touchLink(it->start_address, true);
+        touchFastbin(fastbinIndex(it->size), true);
+        return true;
+    }
+
+    markFree(it);
+    it = coalesceNeighbors(it);
+    if (it->size >= CONSOLIDATE_THRESHOLD && haveFastChunks()) {
+        consolidate(false);
+    }
+    return true;
+}
+
+size_t PtmallocAllocator::deallocateBatch(const vector<Address>& addresses, ProcessId process_id) {
+    // Each free has to pass through the caches, so there is no bulk merge.
+    size_t freed = 0;
+    for (Address address : addresses) {
+        if (deallocateAddress(address, process_id)) {
+            freed++;
+        }
+    }
+    return freed;
+}
+
+Size PtmallocAllocator::allocationSize(Address address, ProcessId process_id) const {
+    auto it = address_index_.find(address);
+    if (it == address_index_.end() || it->second->status != BlockStatus::ALLOCATED ||
+        it->second->process_id != process_id || cached_.count(address)) {
+        return 0;
+    }
+    return it->second->requested_size;
+}
+
+MemoryStats PtmallocAllocator::getStats() const {
+    MemoryStats stats = BaseAllocator::getStats();
+
+    stats.used_memory -= cached_bytes_;
+    stats.free_memory += cached_bytes_;
+    stats.fragmentation_ratio = stats.free_memory > 0
+        ? 1.0 - static_cast<double>(stats.largest_free_block) / stats.free_memory
+        : 0.0;
+    stats.memory_utilization = stats.total_memory > 0
+        ? static_cast<double>(stats.used_memory) / stats.total_memory
+        : 0.0;
+    return stats;
+}
+
+size_t PtmallocAllocator::getMetadataBytes() const {
+    size_t bytes = BaseAllocator::getMetadataBytes();
+    bytes += bin_pos_.size() * (sizeof(BlockIterator) + 2 * sizeof(void*) +
+                                sizeof(pair<const Address, list<BlockIterator>::iterator>) + sizeof(void*));
+    bytes += cached_.size() * (sizeof(Address) + sizeof(void*)) + cached_.bucket_count() * sizeof(void*);
+    for (const auto& slot : tcache_) {
+        bytes += slot.capacity() * sizeof(BlockIterator);
+    }
+    for (const auto& bin : fastbins_) {
+        bytes += bin.capacity() * sizeof(BlockIterator);
+    }
+    return bytes;
+}
+
+Size PtmallocAllocator::compactStep(Size max_bytes, vector<Relocation>& relocations) {
+    consolidate(true);
+    return BaseAllocator::compactStep(max_bytes, relocations);
+}
+
+BlockIterator PtmallocAllocator::findFreeBlock(Size size) {
+    size_t index = binIndex(size);
+    Tier tier = index < NSMALLBINS ? SMALLBIN : LARGEBIN;
+    lookups_[tier]++;
+    size_t scanned = 0;
+    touchBin(index, false);
+
+    // Largebins are sorted, so the first fit in the own bin is the best fit.
+    for (auto block_it : bins_[index]) {
+        scanned++;
+        touchHeader(block_it->start_address, false);
+        if (block_it->size >= size) {
+            hits_[tier]++;
+            recordScan(scanned);
+            return block_it;
+        }
+    }
+
+    // Every chunk in a higher bin fits; take its smallest (or oldest).
+    size_t next_bin = nextNonEmptyBin(index + 1);
+    if (next_bin < NBINS) {
+        // A small request served from a largebin searched both kinds.
+        Tier served = next_bin < NSMALLBINS ? SMALLBIN : LARGEBIN;
+        if (served != tier) {
+            lookups_[served]++;
+        }
+        hits_[served]++;
+        recordScan(scanned + 1);
+        auto& bin = bins_[next_bin];
+        touchBin(next_bin, false);
+        return next_bin < NSMALLBINS ? bin.back() : bin.front();
+    }
+
+    lookups_[TOP]++;
+    recordScan(scanned + 1);
+    touchMetadata(ARENA_TOP, false);
+    if (has_top_) {
+        touchHeader(top_->start_address, false);
+    }
+    if (has_top_ && top_->size >= size) {
+        hits_[TOP]++;
+        return top_;
+    }
+    return memory_blocks_.end();
+}
+
+PtmallocAllocator::BinStats PtmallocAllocator::getBinStats() const {
+    BinStats stats{};
+    copy(begin(lookups_), end(lookups_), stats.lookups);
+    copy(begin(hits_), end(hits_), stats.hits);
+    stats.fast_path = fast_path_;
+    stats.consolidations = consolidations_;
+    stats.top_extensions = top_extensions_;
+    stats.heap_top = brk_;
+
+    stats.cached_chunks = cached_.size();
+    stats.cached_bytes = cached_bytes_;
+    return stats;
+}
+
+Size PtmallocAllocator::chunkSize(Size request) {
+    Size size = (request + CHUNK_HEADER + CHUNK_ALIGN - 1) & ~(CHUNK_ALIGN - 1);
+    return max(size, MIN_CHUNK);
+}
+
+AllocationResult PtmallocAllocator::resizeInPlace(Address address, Size new_size, ProcessId process_id) {
+    auto it = findBlockByAddress(address);
+    if (it == memory_blocks_.end() || it->status != BlockStatus::ALLOCATED ||
+        it->process_id != process_id || cached_.count(address) ||
+        new_size > total_memory_ - min(total_memory_, CHUNK_HEADER + CHUNK_ALIGN)) {
+        return AllocationResult(false, 0, -1);
+    }
+
+    // A tail too small to be a chunk is not worth splitting off.
+    Size chunk_size = chunkSize(new_size);
+    if (chunk_size < it->size && it->size - chunk_size < MIN_CHUNK) {
+        chunk_size = it->size;
+    }
+
+    Size old_size = it->size;
+    Size old_requested = it->requested_size;
+    auto result = BaseAllocator::resizeInPlace(address, chunk_size, process_id);
+    if (!result.success) {
+        return result;
+    }
+
+    internal_fragmentation_ -= old_size - old_requested;
+    internal_fragmentation_ += it->size - new_size;
+    it->requested_size = new_size;
+    extendTop(address + it->size);
+    return result;
+}
+
+void PtmallocAllocator::indexFreeBlock(BlockIterator block_it) {
+    BaseAllocator::indexFreeBlock(block_it);
+
+    if (block_it->start_address + block_it->size == total_memory_) {
+        top_ = block_it;
+        has_top_ = true;
+        touchMetadata(ARENA_TOP, true);
+        return;
+    }
+
+    size_t index = binIndex(block_it->size);
+    auto& bin = bins_[index];
+    auto pos = bin.begin();
+    touchBin(index, false);
+    if (index >= NSMALLBINS) {
+        Size size = block_it->size;
+        pos = find_if(bin.begin(), bin.end(), [this, size](BlockIterator b) {
+            touchHeader(b->start_address, false);
+            return b->size >= size;
+        });
+    }
+
+    // Linking in rewrites the neighbours, or the bin head at either end.
+    if (pos == bin.begin() || pos == bin.end()) {
+        touchBin(index, true);
+    }
+    if (pos != bin.begin()) {
+        touchLink((*prev(pos))->start_address, true);
+    }
+    if (pos != bin.end()) {
+        touchLink((*pos)->start_address, true);
+    }
+    bin_pos_[block_it->start_address] = bin.insert(pos, block_it);
+    binmap_[index / 32] |= 1u << (index % 32);
+    touchBinmap(index, true);
+}
+
+void PtmallocAllocator::unindexFreeBlock(BlockIterator block_it) {
+    BaseAllocator::unindexFreeBlock(block_it);
+
+    auto pos = bin_pos_.find(block_it->start_address);
+    if (pos == bin_pos_.end()) {
+        if (has_top_ && top_ == block_it) {
+            has_top_ = false;
+            touchMetadata(ARENA_TOP, true);
+        }
+        return;
+    }
+
+    size_t index = binIndex(block_it->size);
+    auto& bin = bins_[index];
+    auto at = pos->second;
+    if (at == bin.begin() || next(at) == bin.end()) {
+        touchBin(index, true);
+    }
+    if (at != bin.begin()) {
+        touchLink((*prev(at))->start_address, true);
+    }
+    if (next(at) != bin.end()) {
+        touchLink((*next(at))->start_address, true);
+    }
+    bin.erase(at);
+    bin_pos_.erase(pos);
+    if (bin.empty()) {
+        binmap_[index / 32] &= ~(1u << (index % 32));
+        touchBinmap(index, true);
+    }
+}
+
+BlockIterator PtmallocAllocator::takeCached(Size chunk_size) {
+    if (chunk_size <= MAX_TCACHE_CHUNK) {
+        lookups_[TCACHE]++;
+        auto& slot = tcache_[tcacheIndex(chunk_size)];
+        touchTcache(tcacheIndex(chunk_size), false);
+        if (!slot.empty()) {
+            auto block_it = slot.back();
+            slot.pop_back();
+            cached_.erase(block_it->start_address);
+            cached_bytes_ -= block_it->size;
+            touchLink(block_it->start_address, false);
+            touchTcache(tcacheIndex(chunk_size), true);
+            hits_[TCACHE]++;
+            fast_path_++;
+            recordScan(1);
+            return block_it;
+        }
+    }
+
+    if (chunk_size <= MAX_FAST) {
+        lookups_[FASTBIN]++;
+        auto& bin = fastbins_[fastbinIndex(chunk_size)];
+        touchFastbin(fastbinIndex(chunk_size), false);
+        if (!bin.empty()) {
+            auto block_it = bin.back();
+            bin.pop_back();
+            cached_.erase(block_it->start_address);
+            cached_bytes_ -= block_it->size;
+            touchLink(block_it->start_address, false);
+
+            // The rest of the fastbin refills the tcache slot.
+            auto& slot = tcache_[tcacheIndex(chunk_size)];
+            while (!bin.empty() && slot.size() < TCACHE_COUNT) {
+                touchLink(bin.back()->start_address, false);
+                touchLink(bin.back()->start_address, true);
+                slot.push_back(bin.back());
+                bin.pop_back();
+            }
+            touchFastbin(fastbinIndex(chunk_size), true);
+            touchTcache(tcacheIndex(chunk_size), true);
+            hits_[FASTBIN]++;
+            fast_path_++;
+            recordScan(1);
+            return block_it;
+        }
+    }
+
+    if (chunk_size < MIN_LARGE) {
+        lookups_[SMALLBIN]++;
+        auto& bin = bins_[binIndex(chunk_size)];
+        touchBin(binIndex(chunk_size), false);
+        if (!bin.empty()) {
+            auto block_it = bin.back();
+            markAllocated(block_it, -1);
+
+            // As does the rest of the smallbin.
+            auto& slot = tcache_[tcacheIndex(chunk_size)];
+            while (!bin.empty() && slot.size() < TCACHE_COUNT) {
+                auto extra = bin.back();
+                markAllocated(extra, -1);
+                cacheChunk(slot, extra);
+                touchLink(extra->start_address, true);
+                touchTcache(tcacheIndex(chunk_size), true);
+            }
+            hits_[SMALLBIN]++;
+            fast_path_++;
+            recordScan(1);
+            return block_it;
+        }
+    }
+
+    return memory_blocks_.end();
+}
+
+void PtmallocAllocator::cacheChunk(vector<BlockIterator>& cache, BlockIterator block_it) {
+    cache.push_back(block_it);
+    cached_.insert(block_it->start_address);
+    cached_bytes_ += block_it->size;
+}
+
+size_t PtmallocAllocator::consolidate(bool include_tcache) {
+    vector<BlockIterator> chunks;
+    for (size_t i = 0; i < fastbins_.size(); ++i) {
+        touchFastbin(i, false);
+        if (!fastbins_[i].empty()) {
+            touchFastbin(i, true);
+        }
+        chunks.insert(chunks.end(), fastbins_[i].begin(), fastbins_[i].end());
+        fastbins_[i].clear();
+    }
+    if (include_tcache) {
+        for (size_t i = 0; i < tcache_.size(); ++i) {
+            touchTcache(i, false);
+            if (!tcache_[i].empty()) {
+                touchTcache(i, true);
+            }
+            chunks.insert(chunks.end(), tcache_[i].begin(), tcache_[i].end());
+            tcache_[i].clear();
+        }
+    }
+    if (chunks.empty()) {
+        return 0;
+    }
+
+    consolidations_++;
+    for (auto block_it : chunks) {
+        cached_.erase(block_it->start_address);
+        cached_bytes_ -= block_it->size;
+        touchLink(block_it->start_address, false);
+        markFree(block_it);
+        coalesceNeighbors(block_it);
+    }
+    return chunks.size();
+}
+
+bool PtmallocAllocator::haveFastChunks() const {
+    // glibc keeps this as a flag word at the start of the arena.
+    touchMetadata(ARENA, false);
+    for (const auto& bin : fastbins_) {
+        if (!bin.empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void PtmallocAllocator::extendTop(Address end) {
+    if (end <= brk_) {
+        return;
+    }
+    uint64_t target = uint64_t(end) + TOP_PAD;
+    target = (target + BRK_PAGE - 1) / BRK_PAGE * BRK_PAGE;
+    brk_ = static_cast<Address>(min<uint64_t>(target, total_memory_));
+    top_extensions_++;
+}
+
+size_t PtmallocAllocator::binIndex(Size size) {
+    // glibc's 64-bit bin layout: 16-byte smallbins below 1 KB, then
+    // largebins that get geometrically wider.
+    if (size < MIN_LARGE) {
+        return size / CHUNK_ALIGN;
+    }
+    if ((size >> 6) <= 48) {
+        return 48 + (size >> 6);
+    }
+    if ((size >> 9) <= 20) {
+        return 91 + (size >> 9);
+    }
+    if ((size >> 12) <= 10) {
+        return 110 + (size >> 12);
+    }
+    if ((size >> 15) <= 4) {
+        return 119 + (size >> 15);
+    }
+    if ((size >> 18) <= 2) {
+        return 124 + (size >> 18);
+    }
+    return 126;
+}
+
+size_t PtmallocAllocator::tcacheIndex(Size chunk_size) {
+    return (chunk_size - MIN_CHUNK) / CHUNK_ALIGN;
+}
+
+size_t PtmallocAllocator::fastbinIndex(Size chunk_size) {
+    return (chunk_size - MIN_CHUNK) / CHUNK_ALIGN;
+}
+
+size_t PtmallocAllocator::nextNonEmptyBin(size_t from) const {
+    for (size_t word = from / 32; word < NBINS / 32; ++word) {
+        touchBinmap(word * 32, false);
+        uint32_t map = binmap_[word];
+        if (word == from / 32) {
+            map &= ~0u << (from % 32);
+        }
+        if (map) {
+            return word * 32 + findFirstSet(map);
+        }
+    }
+    return NBINS;
+}
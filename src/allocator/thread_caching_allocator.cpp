@@ -0,0 +1,311 @@
+#include "allocator/thread_caching_allocator.hpp"
+#include <algorithm>
+
+using namespace std;
+
+ThreadCachingAllocator::ThreadCachingAllocator(Backend backend)
+    : backend_(move(backend)),
+      central_batches_(CLASS_COUNT),
+      releasable_spans_(CLASS_COUNT, 0),
+      page_count_(backend_.memory_size / SPAN_ALIGNMENT + 1),
+      lock_acquisitions_(0),
+      batches_fetched_(0),
+      batches_returned_(0),
+      spans_carved_(0),
+      spans_released_(0),
+      invalid_frees_(0)
+{
+    page_map_.reset(new atomic<Span *>[page_count_]);
+    for (size_t i = 0; i < page_count_; ++i)
+    {
+        page_map_[i].store(nullptr, memory_order_relaxed);
+    }
+}
+
+ThreadCachingAllocator::~ThreadCachingAllocator()
+{
+    lock_guard<mutex> guard(lock_);
+    for (size_t size_class = 0; size_class < CLASS_COUNT; ++size_class)
+    {
+        if (releasable_spans_[size_class] > 0)
+            releaseFreeSpans(size_class);
+    }
+}
+
+ThreadCachingAllocator::Stats ThreadCachingAllocator::getStats() const
+{
+    return Stats{lock_acquisitions_.load(),
+                 batches_fetched_.load(),
+                 batches_returned_.load(),
+                 spans_carved_.load(),
+                 spans_released_.load(),
+                 invalid_frees_.load()};
+}
+
+ThreadCachingAllocator::Backend ThreadCachingAllocator::backendFor(BaseAllocator &allocator)
+{
+    return Backend{
+        allocator.getTotalMemory(),
+        [&allocator](const AllocationRequest &request) { return allocator.allocate(request); },
+        [&allocator](Address address, ProcessId process_id)
+        { return allocator.deallocateAddress(address, process_id); }};
+}
+
+ThreadCachingAllocator::Backend ThreadCachingAllocator::backendFor(BuddyAllocator &allocator)
+{
+    return Backend{
+        allocator.getStats().total_memory,
+        [&allocator](const AllocationRequest &request) { return allocator.allocate(request); },
+        [&allocator](Address address, ProcessId) { return allocator.deallocate(address); }};
+}
+
+bool ThreadCachingAllocator::fetchBatch(size_t size_class, ProcessId process_id, vector<Address> &out)
+{
+    lock_guard<mutex> guard(lock_);
+    lock_acquisitions_++;
+
+    auto &batches = central_batches_[size_class];
+    if (!batches.empty())
+    {
+        out.swap(batches.back());
+        batches.pop_back();
+        for (Address address : out)
+        {
+            Span *span = spanFor(address);
+            if (span->central_objects-- == BATCH_SIZE)
+                releasable_spans_[size_class]--;
+        }
+        batches_fetched_++;
+        return true;
+    }
+
+    // Central list is dry: carve a whole batch out of one back-end block.
+    Span *span = carveSpan(size_class, process_id);
+    if (!span)
+        return false;
+
+    // Highest address first, so the cache pops objects in address order.
+    Size object_size = classSize(size_class);
+    for (size_t i = BATCH_SIZE; i-- > 0;)
+    {
+        out.push_back(span->start + i * object_size);
+    }
+    return true;
+}
+
+void ThreadCachingAllocator::returnBatch(size_t size_class, vector<Address> &&batch)
+{
+    lock_guard<mutex> guard(lock_);
+    lock_acquisitions_++;
+    for (Address address : batch)
+    {
+        Span *span = spanFor(address);
+        if (++span->central_objects == BATCH_SIZE)
+            releasable_spans_[size_class]++;
+    }
+
+    auto &batches = central_batches_[size_class];
+    batches.push_back(move(batch));
+    batches_returned_++;
+
+    if (batches.size() > CENTRAL_HIGH_WATERMARK && releasable_spans_[size_class] > 0)
+        releaseFreeSpans(size_class);
+}
+
+ThreadCachingAllocator::Span *ThreadCachingAllocator::carveSpan(size_t size_class, ProcessId process_id)
+{
+    Size span_size = classSize(size_class) * BATCH_SIZE;
+    auto result = backend_.allocate({span_size, process_id, SPAN_ALIGNMENT});
+    if (!result.success)
+        return nullptr;
+
+    Span *span;
+    if (spare_spans_.empty())
+    {
+        spans_.push_back(make_unique<Span>());
+        span = spans_.back().get();
+    }
+    else
+    {
+        span = spare_spans_.back();
+        spare_spans_.pop_back();
+    }
+    span->start = result.address;
+    span->size_class = size_class;
+    span->process_id = process_id;
+    span->live.store(0, memory_order_relaxed);
+    span->central_objects = 0;
+    span->releasing = false;
+
+    size_t first = span->start / SPAN_ALIGNMENT;
+    for (size_t page = first; page < first + span_size / SPAN_ALIGNMENT; ++page)
+    {
+        page_map_[page].store(span, memory_order_release);
+    }
+    spans_carved_++;
+    return span;
+}
+
+void ThreadCachingAllocator::releaseFreeSpans(size_t size_class)
+{
+    auto &batches = central_batches_[size_class];
+    vector<Address> kept;
+    vector<Span *> released;
+    for (const auto &batch : batches)
+    {
+        for (Address address : batch)
+        {
+            Span *span = spanFor(address);
+            if (span->central_objects < BATCH_SIZE)
+            {
+                kept.push_back(address);
+            }
+            else if (!span->releasing)
+            {
+                span->releasing = true;
+                released.push_back(span);
+            }
+        }
+    }
+
+    // Repack what is left into full batches.
+    batches.clear();
+    for (size_t i = 0; i < kept.size(); i += BATCH_SIZE)
+    {
+        batches.emplace_back(kept.begin() + i, kept.begin() + min(i + BATCH_SIZE, kept.size()));
+    }
+    releasable_spans_[size_class] = 0;
+
+    Size span_size = classSize(size_class) * BATCH_SIZE;
+    for (Span *span : released)
+    {
+        size_t first = span->start / SPAN_ALIGNMENT;
+        for (size_t page = first; page < first + span_size / SPAN_ALIGNMENT; ++page)
+        {
+            page_map_[page].store(nullptr, memory_order_release);
+        }
+        backend_.deallocate(span->start, span->process_id);
+        spare_spans_.push_back(span);
+        spans_released_++;
+    }
+}
+
+ThreadCachingAllocator::Span *ThreadCachingAllocator::spanFor(Address address) const
+{
+    size_t page = address / SPAN_ALIGNMENT;
+    if (page >= page_count_)
+        return nullptr;
+    return page_map_[page].load(memory_order_acquire);
+}
+
+void ThreadCachingAllocator::markHandedOut(Address address)
+{
+    Span *span = spanFor(address);
+    size_t index = (address - span->start) / classSize(span->size_class);
+    span->live.fetch_or(1u << index, memory_order_relaxed);
+}
+
+bool ThreadCachingAllocator::markReturned(Address address, size_t size_class)
+{
+    Span *span = spanFor(address);
+    if (span && span->size_class == size_class)
+    {
+        Size object_size = classSize(size_class);
+        Size offset = address - span->start;
+        if (offset % object_size == 0)
+        {
+            uint32_t bit = 1u << (offset / object_size);
+            if (span->live.fetch_and(~bit, memory_order_relaxed) & bit)
+                return true;
+        }
+    }
+    invalid_frees_++;
+    return false;
+}
+
+AllocationResult ThreadCachingAllocator::allocateLarge(Size size, ProcessId process_id)
+{
+    lock_guard<mutex> guard(lock_);
+    lock_acquisitions_++;
+    return backend_.allocate({size, process_id});
+}
+
+bool ThreadCachingAllocator::deallocateLarge(Address address, ProcessId process_id)
+{
+    // A span start passed with a large size would free a whole span.
+    if (spanFor(address))
+    {
+        invalid_frees_++;
+        return false;
+    }
+
+    lock_guard<mutex> guard(lock_);
+    lock_acquisitions_++;
+    return backend_.deallocate(address, process_id);
+}
+
+ThreadCachingAllocator::ThreadCache::ThreadCache(ThreadCachingAllocator &owner, ProcessId process_id)
+    : owner_(owner),
+      process_id_(process_id),
+      free_lists_(CLASS_COUNT)
+{
+}
+
+ThreadCachingAllocator::ThreadCache::~ThreadCache()
+{
+    flush();
+}
+
+AllocationResult ThreadCachingAllocator::ThreadCache::allocate(Size size)
+{
+    if (!isSmall(size))
+        return owner_.allocateLarge(size, process_id_);
+
+    size_t size_class = sizeClass(size);
+    auto &list = free_lists_[size_class];
+    if (list.empty() && !owner_.fetchBatch(size_class, process_id_, list))
+        return AllocationResult(false, 0, -1);
+
+    Address address = list.back();
+    list.pop_back();
+    owner_.markHandedOut(address);
+    return AllocationResult(true, address, static_cast<BlockId>(address));
+}
+
+bool ThreadCachingAllocator::ThreadCache::deallocate(Address address, Size size)
+{
+    if (!isSmall(size))
+        return owner_.deallocateLarge(address, process_id_);
+
+    size_t size_class = sizeClass(size);
+    if (!owner_.markReturned(address, size_class))
+        return false;
+
+    auto &list = free_lists_[size_class];
+    list.push_back(address);
+
+    // Keep up to two batches locally so alternating alloc/free at the
+    // boundary does not bounce a batch through the central list.
+    if (list.size() >= 2 * BATCH_SIZE)
+    {
+        vector<Address> batch(list.end() - BATCH_SIZE, list.end());
+        list.resize(list.size() - BATCH_SIZE);
+        owner_.returnBatch(size_class, move(batch));
+    }
+    return true;
+}
+
+void ThreadCachingAllocator::ThreadCache::flush()
+{
+    for (size_t size_class = 0; size_class < free_lists_.size(); ++size_class)
+    {
+        auto &list = free_lists_[size_class];
+        while (!list.empty())
+        {
+            size_t count = min(list.size(), BATCH_SIZE);
+            vector<Address> batch(list.end() - count, list.end());
+            list.resize(list.size() - count);
+            owner_.returnBatch(size_class, move(batch));
+        }
+    }
+}
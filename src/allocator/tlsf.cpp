@@ -0,0 +1,165 @@
+#include "allocator/tlsf.hpp"
+#include "common/utils.hpp"
+#include <algorithm>
+#include <cstdint>
+
+TlsfAllocator::TlsfAllocator(Size total_memory)
+    : BaseAllocator(total_memory),
+      fl_bitmap_(0),
+      sl_bitmap_{},
+      free_lists_(FL_COUNT * SL_COUNT) {
+}
+
+void TlsfAllocator::initialize(Size total_memory) {
+    fl_bitmap_ = 0;
+    fill(begin(sl_bitmap_), end(sl_bitmap_), 0u);
+    for (auto& bin : free_lists_) {
+        bin.clear();
+    }
+    free_list_pos_.clear();
+
+    BaseAllocator::initialize(total_memory);
+}
+
+AllocationResult TlsfAllocator::allocate(const AllocationRequest& request) {
+    allocation_requests_++;
+    Size search_size = searchSize(request);
+    if (search_size == 0) {
+        allocation_failures_++;
+        return AllocationResult(false, 0, -1);
+    }
+
+    auto block_it = findFreeBlock(search_size);
+    if (block_it == memory_blocks_.end()) {
+        allocation_failures_++;
+        return AllocationResult(false, 0, -1);
+    }
+    block_it = alignBlock(block_it, request.alignment);
+
+    if (block_it->size > request.size) {
+        splitBlock(block_it, request.size);
+    }
+
+    markAllocated(block_it, request.process_id, request.alignment);
+
+    allocation_successes_++;
+    return AllocationResult(true, block_it->start_address, block_it->block_id);
+}
+
+BlockIterator TlsfAllocator::findFreeBlock(Size size) {
+    int fl = 0;
+    int sl = 0;
+    if (!mappingSearch(size, fl, sl)) {
+        return memory_blocks_.end();
+    }
+
+    // First try a larger second-level bin in the same first level, then
+    // the smallest non-empty first level above it.
+    touchSlBitmap(fl, false);
+    uint32_t sl_map = sl_bitmap_[fl] & (~0u << sl);
+    if (sl_map == 0) {
+        touchMetadata(0, false);
+        uint64_t fl_map = fl + 1 < FL_COUNT ? fl_bitmap_ & (~0ull << (fl + 1)) : 0;
+        if (fl_map == 0) {
+            return memory_blocks_.end();
+        }
+        fl = findFirstSet64(fl_map);
+        touchSlBitmap(fl, false);
+        sl_map = sl_bitmap_[fl];
+    }
+    sl = findFirstSet(sl_map);
+    touchHead(fl, sl, false);
+
+    recordScan(1);
+    return binFor(fl, sl).front();
+}
+
+void TlsfAllocator::indexFreeBlock(BlockIterator block_it) {
+    BaseAllocator::indexFreeBlock(block_it);
+
+    int fl = 0;
+    int sl = 0;
+    mappingInsert(block_it->size, fl, sl);
+
+    auto& bin = binFor(fl, sl);
+    if (!bin.empty()) {
+        touchLink(bin.front()->start_address, true);
+    }
+    bin.push_front(block_it);
+    free_list_pos_[block_it->start_address] = bin.begin();
+    touchHead(fl, sl, true);
+
+    if (bin.size() == 1) {
+        fl_bitmap_ |= 1ull << fl;
+        sl_bitmap_[fl] |= 1u << sl;
+        touchMetadata(0, true);
+        touchSlBitmap(fl, true);
+    }
+}
+
+void TlsfAllocator::unindexFreeBlock(BlockIterator block_it) {
+    BaseAllocator::unindexFreeBlock(block_it);
+
+    auto pos = free_list_pos_.find(block_it->start_address);
+    if (pos == free_list_pos_.end()) {
+        return;
+    }
+
+    int fl = 0;
+    int sl = 0;
+    mappingInsert(block_it->size, fl, sl);
+
+    auto& bin = binFor(fl, sl);
+    // Unlinking rewrites both neighbours, or the bin head for the first.
+    auto at = pos->second;
+    if (at == bin.begin()) {
+        touchHead(fl, sl, true);
+    } else {
+        touchLink((*prev(at))->start_address, true);
+    }
+    if (next(at) != bin.end()) {
+        touchLink((*next(at))->start_address, true);
+    }
+    bin.erase(at);
+    free_list_pos_.erase(pos);
+
+    if (bin.empty()) {
+        sl_bitmap_[fl] &= ~(1u << sl);
+        touchSlBitmap(fl, true);
+        if (sl_bitmap_[fl] == 0) {
+            fl_bitmap_ &= ~(1ull << fl);
+            touchMetadata(0, true);
+        }
+    }
+}
+
+void TlsfAllocator::mappingInsert(Size size, int& fl, int& sl) const {
+    if (size < static_cast<Size>(SL_COUNT)) {
+        fl = 0;
+        sl = static_cast<int>(size);
+        return;
+    }
+
+    int msb = findLastSet64(size);
+    sl = static_cast<int>(size >> (msb - SL_LOG2)) - SL_COUNT;
+    fl = msb - SL_LOG2 + 1;
+}
+
+bool TlsfAllocator::mappingSearch(Size size, int& fl, int& sl) const {
+    Size rounded = size;
+    if (size >= static_cast<Size>(SL_COUNT)) {
+        Size step = (Size(1) << (findLastSet64(size) - SL_LOG2)) - 1;
+        if (size > UINT64_MAX - step) {
+            return false;
+        }
+        rounded += step;
+    }
+
+    // Round up to the next bin boundary so any block found there fits.
+    mappingInsert(rounded, fl, sl);
+    return true;
+}
+
+list<BlockIterator>& TlsfAllocator::binFor(int fl, int sl) {
+    return free_lists_[fl * SL_COUNT + sl];
+}
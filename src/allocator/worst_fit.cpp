@@ -8,43 +8,38 @@ WorstFitAllocator::WorstFitAllocator(Size total_memory)
 AllocationResult WorstFitAllocator::allocate(const AllocationRequest& request) {
     allocation_requests_++;
 
-    if (request.size == 0) {
+    Size search_size = searchSize(request);
+    if (search_size == 0) {
         allocation_failures_++;
         return AllocationResult(false, 0, -1);
     }
 
-
-    auto block_it = findFreeBlock(request.size);
+    auto block_it = findFreeBlock(search_size);
     if (block_it == memory_blocks_.end()) {
         allocation_failures_++;
         return AllocationResult(false, 0, -1);
     }
-    Address alloc_address = block_it->start_address;
-    BlockId alloc_block_id = block_it->block_id;
+    block_it = alignBlock(block_it, request.alignment);
     if (block_it->size > request.size) {
         splitBlock(block_it, request.size);
-        block_it = findBlockById(alloc_block_id);
     }
 
-    block_it->status = BlockStatus::ALLOCATED;
-    block_it->process_id = request.process_id;
+    markAllocated(block_it, request.process_id, request.alignment);
 
     allocation_successes_++;
     return AllocationResult(true, block_it->start_address, block_it->block_id);
 }
 
-vector<MemoryBlock>::iterator WorstFitAllocator::findFreeBlock(Size size) {
-    vector<MemoryBlock>::iterator worst_fit = memory_blocks_.end();
-    Size largest_size = 0;
-
-    for (auto it = memory_blocks_.begin(); it != memory_blocks_.end(); ++it) {
-        if (it->status == BlockStatus::FREE && it->size >= size) {
-            if (it->size > largest_size) {
-                largest_size = it->size;
-                worst_fit = it;
-            }
-        }
+BlockIterator WorstFitAllocator::findFreeBlock(Size size) {
+    touchSizeIndexPath(free_by_size_.end());
+    if (free_by_size_.empty() || free_by_size_.rbegin()->first.first < size) {
+        return memory_blocks_.end();
     }
 
-    return worst_fit;
+    // Largest free block; ties go to the lowest address.
+    Size largest_size = free_by_size_.rbegin()->first.first;
+    auto worst_fit = free_by_size_.lower_bound({largest_size, 0});
+    recordScan(1);
+
+    return worst_fit->second;
 }
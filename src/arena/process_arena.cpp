@@ -0,0 +1,172 @@
+#include "arena/process_arena.hpp"
+#include <algorithm>
+
+using namespace std;
+
+ProcessArena::ProcessArena(Size chunk_size)
+    : chunk_size_(chunk_size),
+      current_(0),
+      has_current_(false),
+      live_objects_(0)
+{
+}
+
+AllocationResult ProcessArena::allocate(BaseAllocator &backing, const AllocationRequest &request)
+{
+    if (request.size == 0)
+        return AllocationResult(false, 0, -1);
+
+    Size size = (request.size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+
+    Address base = current_;
+    Chunk *chunk = has_current_ ? &chunks_.at(current_) : nullptr;
+    if (!chunk || chunk->size - chunk->used < size)
+    {
+        // Oversized requests get a chunk of their own and leave the
+        // current chunk in place for the small ones that follow.
+        Size chunk_size = max(size, chunk_size_);
+        auto result = backing.allocate({chunk_size, request.process_id, ALIGNMENT});
+        if (!result.success)
+            return AllocationResult(false, 0, -1);
+
+        if (chunk_size == chunk_size_)
+        {
+            // Nothing more is carved from the old chunk, so it goes back
+            // now if it is already empty.
+            auto old = chunks_.find(current_);
+            if (has_current_ && old->second.live_objects == 0)
+            {
+                backing.deallocateAddress(old->first, request.process_id);
+                chunks_.erase(old);
+            }
+            current_ = result.address;
+            has_current_ = true;
+        }
+
+        base = result.address;
+        chunk = &chunks_[base];
+        chunk->size = chunk_size;
+        chunk->used = 0;
+        chunk->live_objects = 0;
+    }
+
+    Address address = base + chunk->used;
+    chunk->used += size;
+    chunk->live_objects++;
+    chunk->objects.emplace_back(address, size);
+    live_objects_++;
+
+    return AllocationResult(true, address, static_cast<BlockId>(address));
+}
+
+bool ProcessArena::deallocate(BaseAllocator &backing, Address address, ProcessId process_id)
+{
+    auto it = chunks_.upper_bound(address);
+    if (it == chunks_.begin())
+        return false;
+    --it;
+
+    Chunk &chunk = it->second;
+    size_t index = findObject(chunk, address);
+    if (index == chunk.objects.size())
+        return false;
+
+    chunk.objects[index].second = 0;
+    chunk.live_objects--;
+    live_objects_--;
+
+    if (has_current_ && it->first == current_)
+    {
+        // Trim freed objects off the top so the bump pointer can reuse them.
+        while (!chunk.objects.empty() && chunk.objects.back().second == 0)
+        {
+            chunk.objects.pop_back();
+        }
+        chunk.used = chunk.objects.empty()
+                         ? 0
+                         : chunk.objects.back().first + chunk.objects.back().second - it->first;
+    }
+    else if (chunk.live_objects == 0)
+    {
+        backing.deallocateAddress(it->first, process_id);
+        chunks_.erase(it);
+    }
+
+    return true;
+}
+
+size_t ProcessArena::releaseAll(BaseAllocator &backing, ProcessId process_id)
+{
+    size_t released = 0;
+    for (const auto &c : chunks_)
+    {
+        if (backing.deallocateAddress(c.first, process_id))
+            released++;
+    }
+    reset();
+    return released;
+}
+
+void ProcessArena::reset()
+{
+    chunks_.clear();
+    has_current_ = false;
+    current_ = 0;
+    live_objects_ = 0;
+}
+
+bool ProcessArena::relocateChunk(Address old_base, Address new_base,
+                                 vector<pair<Address, Address>> &moved_objects)
+{
+    auto it = chunks_.find(old_base);
+    if (it == chunks_.end())
+        return false;
+
+    Chunk chunk = move(it->second);
+    chunks_.erase(it);
+
+    for (auto &obj : chunk.objects)
+    {
+        Address address = obj.first - old_base + new_base;
+        if (obj.second != 0)
+            moved_objects.emplace_back(obj.first, address);
+        obj.first = address;
+    }
+    chunks_[new_base] = move(chunk);
+
+    if (has_current_ && current_ == old_base)
+        current_ = new_base;
+    return true;
+}
+
+bool ProcessArena::owns(Address address) const
+{
+    return objectSize(address) != 0;
+}
+
+Size ProcessArena::objectSize(Address address) const
+{
+    auto it = chunks_.upper_bound(address);
+    if (it == chunks_.begin())
+        return 0;
+    --it;
+
+    size_t index = findObject(it->second, address);
+    return index == it->second.objects.size() ? 0 : it->second.objects[index].second;
+}
+
+Size ProcessArena::reservedBytes() const
+{
+    Size total = 0;
+    for (const auto &c : chunks_)
+        total += c.second.size;
+    return total;
+}
+
+size_t ProcessArena::findObject(const Chunk &chunk, Address address)
+{
+    auto it = lower_bound(chunk.objects.begin(), chunk.objects.end(), make_pair(address, Size(0)));
+    if (it == chunk.objects.end() || it->first != address || it->second == 0)
+        return chunk.objects.size();
+    return it - chunk.objects.begin();
+}
@@ -8,42 +8,73 @@ using namespace std;
 BuddyAllocator::BuddyAllocator(Size total_memory)
     : total_memory_(total_memory)
 {
-    if (!isPowerOfTwo(total_memory))
+    if (total_memory == 0)
     {
-        throw invalid_argument("Total memory must be a power of 2");
+        throw invalid_argument("Total memory must be positive");
     }
 
     max_order_ = log2Floor(total_memory);
-    free_lists_.resize(max_order_ + 1);
+    free_lists_.assign(max_order_ + 1, FreeList{NIL, NIL, 0});
+
+    Size offset = 0;
+    for (int order = 0; order <= max_order_; ++order)
+    {
+        bitmap_offsets_.push_back(offset);
+        offset += ((total_memory >> order) + 7) / 8;
+    }
 }
 
 void BuddyAllocator::initialize()
 {
-    free_lists_.clear();
-    free_lists_.resize(max_order_ + 1);
+    free_nodes_.clear();
+    free_lists_.assign(max_order_ + 1, FreeList{NIL, NIL, 0});
     allocated_blocks_.clear();
-    free_lists_[max_order_].push_back(0);
+
+    nonempty_orders_ = 0;
+    used_bytes_ = 0;
+    free_blocks_ = 0;
+
+    // Cover memory with the largest blocks that are aligned to their own
+    // size and fit before the end, as a zone seeds its free areas. A power
+    // of two is a single block; 48 GiB is 32 GiB followed by 16 GiB.
+    Address address = 0;
+    while (address < total_memory_)
+    {
+        int order = log2Floor(total_memory_ - address);
+        if (address != 0)
+        {
+            order = min(order, findFirstSet64(address));
+        }
+        pushFree(order, address);
+        address += getBlockSize(order);
+    }
 }
 
 AllocationResult BuddyAllocator::allocate(const AllocationRequest &request)
+{
+    return allocateBlock(request, false);
+}
+
+AllocationResult BuddyAllocator::allocateExact(const AllocationRequest &request)
+{
+    return allocateBlock(request, true);
+}
+
+AllocationResult BuddyAllocator::allocateBlock(const AllocationRequest &request, bool exact)
 {
     allocation_requests_++;
-    if (request.size == 0 || request.size > total_memory_)
+    if (request.size == 0 || request.size > total_memory_ ||
+        (request.alignment > 1 && (!isPowerOfTwo(request.alignment) || request.alignment > total_memory_)))
     {
         allocation_failures_++;
         return AllocationResult(false, 0, -1);
     }
 
     Size actual_size = nextPowerOfTwo(request.size);
-    int required_order = getOrder(actual_size);
+    int required_order = getOrder(max(actual_size, request.alignment));
 
-    int order = required_order;
-    while (order <= max_order_ && free_lists_[order].empty())
-    {
-        order++;
-    }
-
-    if (order > max_order_)
+    int order = firstFreeOrder(required_order);
+    if (order < 0)
     {
         allocation_failures_++;
         return AllocationResult(false, 0, -1);
@@ -55,14 +86,34 @@ AllocationResult BuddyAllocator::allocate(const AllocationRequest &request)
         order--;
     }
 
-    Address address = free_lists_[order].front();
-    free_lists_[order].pop_front();
+    Address address = popFree(order);
 
     allocated_blocks_[address] =
-        make_tuple(required_order, request.process_id, request.size);
-
+        make_tuple(required_order, request.process_id, request.size, exact);
+    touchRecord(address, true);
     allocation_successes_++;
+    if (request.alignment > 1)
+    {
+        aligned_allocations_++;
+    }
+
+    if (exact)
+    {
+        // Everything past the request goes straight back as whole buddies.
+        Size trimmed = getBlockSize(required_order) - request.size;
+        releaseRange(address + request.size, address + getBlockSize(required_order));
+        used_bytes_ += request.size;
+        exact_allocations_++;
+        exact_trimmed_ += trimmed;
+        return AllocationResult(true, address, static_cast<BlockId>(address));
+    }
+
+    used_bytes_ += getBlockSize(required_order);
     internal_fragmentation_ += (actual_size - request.size);
+    if (request.alignment > 1)
+    {
+        alignment_waste_ += getBlockSize(required_order) - actual_size;
+    }
 
     return AllocationResult(true, address, static_cast<BlockId>(address));
 }
@@ -77,51 +128,288 @@ bool BuddyAllocator::deallocate(Address address)
 
     int order = get<0>(it->second);
     Size requested_size = get<2>(it->second);
-    Size block_size = getBlockSize(order);
-
-    internal_fragmentation_ -= (block_size - requested_size);
+    bool exact = get<3>(it->second);
+    touchRecord(address, false);
 
     allocated_blocks_.erase(it);
+    touchRecord(address, true);
+
+    if (exact)
+    {
+        used_bytes_ -= requested_size;
+        releaseRange(address, address + requested_size);
+        return true;
+    }
+
+    // Any extra order taken for alignment is counted as alignment waste,
+    // not internal fragmentation.
+    internal_fragmentation_ -= (nextPowerOfTwo(requested_size) - requested_size);
+    used_bytes_ -= getBlockSize(order);
     mergeBuddies(order, address);
 
     return true;
 }
 
-MemoryStats BuddyAllocator::getStats() const
+AllocationResult BuddyAllocator::reallocate(Address address, Size new_size)
 {
-    MemoryStats stats;
-    stats.total_memory = total_memory_;
+    auto it = allocated_blocks_.find(address);
+    if (it == allocated_blocks_.end() || new_size == 0 || new_size > total_memory_)
+    {
+        return AllocationResult(false, 0, -1);
+    }
 
-    Size used = 0;
-    for (const auto &pair : allocated_blocks_)
+    int order = get<0>(it->second);
+    ProcessId process_id = get<1>(it->second);
+    Size old_size = get<2>(it->second);
+    bool exact = get<3>(it->second);
+    int new_order = getOrder(new_size);
+    touchRecord(address, false);
+
+    if (exact)
     {
-        used += getBlockSize(get<0>(pair.second));
+        return reallocateExact(address, new_size);
+    }
 
+    if (new_order > order && !growInPlace(address, order, new_order))
+    {
+        auto result = allocate({new_size, process_id, movedAlignment(order, new_size)});
+        if (!result.success)
+        {
+            return result;
+        }
+        realloc_moved_++;
+        realloc_bytes_copied_ += min(old_size, new_size);
+        deallocate(address);
+        return result;
     }
 
-    stats.used_memory = used;
-    stats.free_memory = total_memory_ - used;
-    stats.total_blocks = allocated_blocks_.size();
-    stats.allocated_blocks = allocated_blocks_.size();
+    // Shrinking keeps the lower half at each level and frees the upper one.
+    for (int o = order; o > new_order; --o)
+    {
+        mergeBuddies(o - 1, address + getBlockSize(o - 1));
+    }
 
-    stats.internal_fragmentation = internal_fragmentation_;
-    stats.allocation_requests = allocation_requests_;
-    stats.allocation_successes = allocation_successes_;
-    stats.allocation_failures = allocation_failures_;
+    internal_fragmentation_ -= nextPowerOfTwo(old_size) - old_size;
+    internal_fragmentation_ += nextPowerOfTwo(new_size) - new_size;
+    it->second = make_tuple(new_order, process_id, new_size, false);
+    touchRecord(address, true);
+    used_bytes_ = used_bytes_ - getBlockSize(order) + getBlockSize(new_order);
+    realloc_in_place_++;
+
+    return AllocationResult(true, address, static_cast<BlockId>(address));
+}
+
+bool BuddyAllocator::growInPlace(Address address, int order, int new_order)
+{
+    // The block must be the lower half at every level up to new_order, and
+    // each upper half must be free.
+    vector<Address> buddies;
+    for (int o = order; o < new_order; ++o)
+    {
+        if (address % getBlockSize(o + 1) != 0)
+        {
+            return false;
+        }
+        Address buddy = address + getBlockSize(o);
+        if (!isFree(o, buddy))
+        {
+            return false;
+        }
+        buddies.push_back(buddy);
+    }
+
+    for (int o = order; o < new_order; ++o)
+    {
+        unlinkFree(o, buddies[o - order]);
+    }
+    return true;
+}
+
+Size BuddyAllocator::movedAlignment(int order, Size new_size) const
+{
+    Size block_size = getBlockSize(order);
+    return block_size > nextPowerOfTwo(new_size) ? block_size : 0;
+}
 
-    size_t free_count = 0;
-    Size largest_free = 0;
+AllocationResult BuddyAllocator::reallocateExact(Address address, Size new_size)
+{
+    auto it = allocated_blocks_.find(address);
+    int order = get<0>(it->second);
+    ProcessId process_id = get<1>(it->second);
+    Size old_size = get<2>(it->second);
 
-    for (int i = 0; i <= max_order_; ++i)
+    // Shrinking hands the cut-off tail back; growing always moves.
+    if (new_size > old_size)
     {
-        free_count += free_lists_[i].size();
-        if (!free_lists_[i].empty())
+        auto result = allocateExact({new_size, process_id, movedAlignment(order, new_size)});
+        if (!result.success)
         {
-            largest_free = max(largest_free, getBlockSize(i));
+            return result;
         }
+        realloc_moved_++;
+        realloc_bytes_copied_ += old_size;
+        deallocate(address);
+        return result;
     }
 
-    stats.free_blocks = free_count;
+    releaseRange(address + new_size, address + old_size);
+    used_bytes_ -= old_size - new_size;
+    get<2>(it->second) = new_size;
+    touchRecord(address, true);
+    realloc_in_place_++;
+
+    return AllocationResult(true, address, static_cast<BlockId>(address));
+}
+
+void BuddyAllocator::releaseRange(Address start, Address end)
+{
+    // Lowest address first, each piece the largest block aligned to its
+    // own size that still fits. A piece merges with its buddy when that is
+    // free, so releasing the rest of a block rebuilds it.
+    while (start < end)
+    {
+        int order = log2Floor(end - start);
+        if (start != 0)
+        {
+            order = min(order, findFirstSet64(start));
+        }
+        mergeBuddies(order, start);
+        start += getBlockSize(order);
+    }
+}
+
+vector<AllocationResult> BuddyAllocator::allocateBatch(const vector<Size> &sizes, ProcessId process_id,
+                                                       bool exact)
+{
+    vector<AllocationResult> results;
+    results.reserve(sizes.size());
+    for (Size size : sizes)
+    {
+        results.push_back(allocateBlock({size, process_id}, exact));
+    }
+    return results;
+}
+
+size_t BuddyAllocator::deallocateBatch(const vector<Address> &addresses)
+{
+    return freeBulk(addresses);
+}
+
+vector<Address> BuddyAllocator::allocateBulk(int order, size_t count, ProcessId process_id)
+{
+    vector<Address> addresses;
+    if (order < 0 || order > max_order_)
+    {
+        allocation_requests_ += count;
+        allocation_failures_ += count;
+        return addresses;
+    }
+    addresses.reserve(count);
+
+    // Each pass takes the smallest free block that holds at least one
+    // block of this order and carves it in one go: as many blocks as are
+    // still wanted from the front, and the rest back as whole buddies.
+    Size size = getBlockSize(order);
+    while (addresses.size() < count)
+    {
+        int from = firstFreeOrder(order);
+        if (from < 0)
+        {
+            break;
+        }
+
+        Address base = popFree(from);
+        Size fits = getBlockSize(from - order);
+        Size take = min<Size>(fits, count - addresses.size());
+        for (Size i = 0; i < take; ++i)
+        {
+            Address address = base + i * size;
+            allocated_blocks_[address] = make_tuple(order, process_id, size, false);
+            touchRecord(address, true);
+            addresses.push_back(address);
+        }
+        releaseRange(base + take * size, base + getBlockSize(from));
+    }
+
+    used_bytes_ += addresses.size() * size;
+    allocation_requests_ += count;
+    allocation_successes_ += addresses.size();
+    allocation_failures_ += count - addresses.size();
+    return addresses;
+}
+
+size_t BuddyAllocator::freeBulk(const vector<Address> &addresses)
+{
+    // Drop every record first, then release each run of adjacent blocks as
+    // the largest aligned pieces that fit, so a run of N pages costs a few
+    // merges instead of N.
+    vector<pair<Address, Address>> ranges;
+    ranges.reserve(addresses.size());
+    for (Address address : addresses)
+    {
+        auto it = allocated_blocks_.find(address);
+        if (it == allocated_blocks_.end())
+        {
+            continue;
+        }
+
+        int order = get<0>(it->second);
+        Size requested_size = get<2>(it->second);
+        Size size = requested_size;
+        if (!get<3>(it->second))
+        {
+            internal_fragmentation_ -= nextPowerOfTwo(requested_size) - requested_size;
+            size = getBlockSize(order);
+        }
+        touchRecord(address, false);
+        allocated_blocks_.erase(it);
+        touchRecord(address, true);
+        used_bytes_ -= size;
+        ranges.emplace_back(address, address + size);
+    }
+    sort(ranges.begin(), ranges.end());
+
+    size_t i = 0;
+    while (i < ranges.size())
+    {
+        Address start = ranges[i].first;
+        Address end = ranges[i].second;
+        for (++i; i < ranges.size() && ranges[i].first == end; ++i)
+        {
+            end = ranges[i].second;
+        }
+        releaseRange(start, end);
+    }
+    return ranges.size();
+}
+
+MemoryStats BuddyAllocator::getStats() const
+{
+    MemoryStats stats;
+    stats.total_memory = total_memory_;
+
+    stats.used_memory = used_bytes_;
+    stats.free_memory = total_memory_ - used_bytes_;
+    stats.total_blocks = allocated_blocks_.size();
+    stats.allocated_blocks = allocated_blocks_.size();
+
+    stats.internal_fragmentation = internal_fragmentation_;
+    stats.allocation_requests = allocation_requests_;
+    stats.allocation_successes = allocation_successes_;
+    stats.allocation_failures = allocation_failures_;
+    stats.realloc_in_place = realloc_in_place_;
+    stats.realloc_moved = realloc_moved_;
+    stats.realloc_bytes_copied = realloc_bytes_copied_;
+    stats.aligned_allocations = aligned_allocations_;
+    stats.alignment_waste = alignment_waste_;
+    stats.exact_allocations = exact_allocations_;
+    stats.exact_trimmed = exact_trimmed_;
+
+    // The largest free block is the highest non-empty order.
+    Size largest_free =
+        nonempty_orders_ ? getBlockSize(findLastSet64(nonempty_orders_)) : 0;
+
+    stats.free_blocks = free_blocks_;
     stats.largest_free_block = largest_free;
     if (stats.free_memory > 0)
     {
@@ -154,10 +442,11 @@ vector<MemoryBlock> BuddyAllocator::getAllocatedBlocks() const
         Address addr = pair.first;
         int order = get<0>(pair.second);
         ProcessId pid = get<1>(pair.second);
+        Size size = get<3>(pair.second) ? get<2>(pair.second) : getBlockSize(order);
 
         blocks.emplace_back(
             addr,
-            getBlockSize(order),
+            size,
             BlockStatus::ALLOCATED,
             pid,
             static_cast<BlockId>(addr));
@@ -173,7 +462,8 @@ vector<MemoryBlock> BuddyAllocator::getFreeBlocks() const
     for (int order = 0; order <= max_order_; ++order)
     {
         Size size = getBlockSize(order);
-        for (Address addr : free_lists_[order])
+        for (Address addr = free_lists_[order].head; addr != NIL;
+             addr = free_nodes_.at(addr).next)
         {
             blocks.emplace_back(addr, size, BlockStatus::FREE, -1, static_cast<BlockId>(addr));
         }
@@ -194,39 +484,35 @@ Address BuddyAllocator::getBuddyAddress(Address address, int order) const
 
 void BuddyAllocator::splitBlock(int order)
 {
-    if (order == 0 || free_lists_[order].empty())
+    if (order == 0 || free_lists_[order].count == 0)
         return;
 
-    Address address = free_lists_[order].front();
-    free_lists_[order].pop_front();
+    Address address = popFree(order);
 
     int lower = order - 1;
     Size half = getBlockSize(lower);
 
-    free_lists_[lower].push_back(address);
-    free_lists_[lower].push_back(address + half);
+    pushFree(lower, address);
+    pushFree(lower, address + half);
 }
 
 void BuddyAllocator::mergeBuddies(int order, Address address)
 {
     if (order == max_order_)
     {
-        free_lists_[order].push_back(address);
+        pushFree(order, address);
         return;
     }
 
     Address buddy = getBuddyAddress(address, order);
-    auto &list = free_lists_[order];
-
-    auto it = find(list.begin(), list.end(), buddy);
-    if (it != list.end())
+    if (isFree(order, buddy))
     {
-        list.erase(it);
+        unlinkFree(order, buddy);
         mergeBuddies(order + 1, min(address, buddy));
     }
     else
     {
-        list.push_back(address);
+        pushFree(order, address);
     }
 }
 
@@ -240,3 +526,139 @@ Size BuddyAllocator::getBlockSize(int order) const
 {
     return static_cast<Size>(1) << order;
 }
+
+void BuddyAllocator::setMetadataObserver(MetadataObserver observer)
+{
+    metadata_observer_ = move(observer);
+}
+
+void BuddyAllocator::pushFree(int order, Address address)
+{
+    // Appending rewrites the old tail's next link and the head's tail link.
+    auto &list = free_lists_[order];
+    if (list.tail != NIL)
+    {
+        free_nodes_[list.tail].next = address;
+        touchNode(list.tail, true);
+    }
+    else
+    {
+        list.head = address;
+    }
+    free_nodes_[address] = FreeNode{order, list.tail, NIL};
+    touchNode(address, true);
+    list.tail = address;
+    touchHead(order, true);
+    touchBit(order, address, true);
+
+    if (list.count++ == 0)
+    {
+        nonempty_orders_ |= 1ull << order;
+        touchMask(true);
+    }
+    free_blocks_++;
+}
+
+Address BuddyAllocator::popFree(int order)
+{
+    touchHead(order, false);
+    Address address = free_lists_[order].head;
+    unlinkFree(order, address);
+    return address;
+}
+
+bool BuddyAllocator::isFree(int order, Address address) const
+{
+    touchBit(order, address, false);
+    auto it = free_nodes_.find(address);
+    return it != free_nodes_.end() && it->second.order == order;
+}
+
+void BuddyAllocator::unlinkFree(int order, Address address)
+{
+    auto &list = free_lists_[order];
+    auto it = free_nodes_.find(address);
+    FreeNode node = it->second;
+    free_nodes_.erase(it);
+    touchNode(address, false);
+
+    if (node.prev != NIL)
+    {
+        free_nodes_[node.prev].next = node.next;
+        touchNode(node.prev, true);
+    }
+    else
+    {
+        list.head = node.next;
+    }
+    if (node.next != NIL)
+    {
+        free_nodes_[node.next].prev = node.prev;
+        touchNode(node.next, true);
+    }
+    else
+    {
+        list.tail = node.prev;
+    }
+    if (node.prev == NIL || node.next == NIL)
+        touchHead(order, true);
+    touchBit(order, address, true);
+
+    if (--list.count == 0)
+    {
+        nonempty_orders_ &= ~(1ull << order);
+        touchMask(true);
+    }
+    free_blocks_--;
+}
+
+int BuddyAllocator::firstFreeOrder(int order) const
+{
+    touchMask(false);
+    uint64_t candidates = order > max_order_ ? 0 : nonempty_orders_ & (~0ull << order);
+    return candidates ? findFirstSet64(candidates) : -1;
+}
+
+void BuddyAllocator::touchMask(bool is_write) const
+{
+    // The mask word sits right after the last list head.
+    if (metadata_observer_)
+        metadata_observer_(static_cast<Address>(total_memory_ + (max_order_ + 1) * 16), is_write);
+}
+
+void BuddyAllocator::touchHead(int order, bool is_write) const
+{
+    if (metadata_observer_ && order <= max_order_)
+        metadata_observer_(static_cast<Address>(total_memory_ + order * 16), is_write);
+}
+
+void BuddyAllocator::touchBit(int order, Address address, bool is_write) const
+{
+    if (!metadata_observer_ || order > max_order_)
+        return;
+    // One bit per block of each order, after the allocation records.
+    Size heads = alignUp(static_cast<Address>((max_order_ + 2) * 16), 64);
+    Size records = max<Size>(total_memory_ / 16, 1) * 16;
+    Size bit = address >> order;
+    metadata_observer_(static_cast<Address>(total_memory_ + heads + records +
+                                            bitmap_offsets_[order] + bit / 8),
+                       is_write);
+}
+
+void BuddyAllocator::touchNode(Address address, bool is_write) const
+{
+    if (metadata_observer_)
+        metadata_observer_(address, is_write);
+}
+
+void BuddyAllocator::touchRecord(Address address, bool is_write) const
+{
+    if (!metadata_observer_)
+        return;
+    // A hash table of 16-byte slots after the list heads and the mask, one
+    // slot per smallest block.
+    Size heads = alignUp(static_cast<Address>((max_order_ + 2) * 16), 64);
+    size_t slots = max<size_t>(total_memory_ / 16, 1);
+    size_t slot = (static_cast<uint64_t>(address) * 11400714819323198485ull) % slots;
+    metadata_observer_(static_cast<Address>(total_memory_ + heads + slot * 16), is_write);
+}
@@ -0,0 +1,140 @@
+#include "buddy/page_cache.hpp"
+#include "common/utils.hpp"
+#include <algorithm>
+
+using namespace std;
+
+PageCache::Stats &PageCache::Stats::operator+=(const Stats &other)
+{
+    allocations += other.allocations;
+    allocation_hits += other.allocation_hits;
+    allocation_failures += other.allocation_failures;
+    frees += other.frees;
+    free_hits += other.free_hits;
+    refills += other.refills;
+    drains += other.drains;
+    pages_requested += other.pages_requested;
+    pages_refilled += other.pages_refilled;
+    pages_drained += other.pages_drained;
+    cached_pages += other.cached_pages;
+    pages_in_use += other.pages_in_use;
+    return *this;
+}
+
+PageCache::PageCache(Size page_size, ProcessId process_id, size_t low, size_t high)
+    : page_size_(page_size),
+      process_id_(process_id),
+      low_(min(low, high)),
+      high_(high),
+      stats_{}
+{
+}
+
+void PageCache::setWatermarks(BuddyAllocator &buddy, size_t low, size_t high)
+{
+    drain(buddy);
+    low_ = min(low, high);
+    high_ = high;
+}
+
+AllocationResult PageCache::allocate(BuddyAllocator &buddy)
+{
+    stats_.allocations++;
+    if (free_pages_.empty())
+    {
+        // Refill in one bulk call. The pages come back lowest first and are
+        // pushed in reverse, so the lowest one goes out first.
+        int order = log2Floor(nextPowerOfTwo(page_size_));
+        size_t count = max<size_t>(low_, 1);
+        auto pages = buddy.allocateBulk(order, count, process_id_);
+        stats_.pages_requested += count;
+        if (pages.empty())
+        {
+            stats_.allocation_failures++;
+            return AllocationResult(false, 0, -1);
+        }
+        stats_.refills++;
+        stats_.pages_refilled += pages.size();
+        free_pages_.assign(pages.rbegin(), pages.rend());
+    }
+    else
+    {
+        stats_.allocation_hits++;
+    }
+
+    Address address = free_pages_.back();
+    free_pages_.pop_back();
+    in_use_.insert(address);
+
+    return AllocationResult(true, address, static_cast<BlockId>(address));
+}
+
+bool PageCache::deallocate(BuddyAllocator &buddy, Address address)
+{
+    if (!in_use_.erase(address))
+    {
+        return false;
+    }
+
+    stats_.frees++;
+    free_pages_.push_back(address);
+    if (free_pages_.size() > high_)
+    {
+        stats_.drains++;
+        shrinkTo(buddy, low_);
+    }
+    else
+    {
+        stats_.free_hits++;
+    }
+    return true;
+}
+
+size_t PageCache::drain(BuddyAllocator &buddy)
+{
+    size_t drained = free_pages_.size();
+    if (drained > 0)
+    {
+        stats_.drains++;
+        shrinkTo(buddy, 0);
+    }
+    return drained;
+}
+
+size_t PageCache::releaseAll(BuddyAllocator &buddy)
+{
+    vector<Address> pages(free_pages_);
+    pages.insert(pages.end(), in_use_.begin(), in_use_.end());
+    size_t released = buddy.freeBulk(pages);
+    reset();
+    return released;
+}
+
+void PageCache::reset()
+{
+    free_pages_.clear();
+    in_use_.clear();
+}
+
+PageCache::Stats PageCache::getStats() const
+{
+    Stats stats = stats_;
+    stats.cached_pages = free_pages_.size();
+    stats.pages_in_use = in_use_.size();
+    return stats;
+}
+
+void PageCache::shrinkTo(BuddyAllocator &buddy, size_t keep)
+{
+    if (free_pages_.size() <= keep)
+    {
+        return;
+    }
+
+    // The coldest pages are at the front.
+    size_t count = free_pages_.size() - keep;
+    vector<Address> cold(free_pages_.begin(), free_pages_.begin() + count);
+    free_pages_.erase(free_pages_.begin(), free_pages_.begin() + count);
+    buddy.freeBulk(cold);
+    stats_.pages_drained += count;
+}
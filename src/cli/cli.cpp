@@ -43,6 +43,12 @@ void CLI::registerCommands()
     commands_["terminate"] = {"terminate", "Terminate a process", bind(&CLI::handleTerminateProcess, this, _1)};
     commands_["alloc"] = {"alloc", "Allocate memory", bind(&CLI::handleAllocate, this, _1)};
     commands_["free"] = {"free", "Deallocate memory", bind(&CLI::handleDeallocate, this, _1)};
+    commands_["realloc"] = {"realloc", "Resize allocated memory", bind(&CLI::handleReallocate, this, _1)};
+    commands_["allocb"] = {"allocb", "Allocate a batch of blocks", bind(&CLI::handleAllocateBatch, this, _1)};
+    commands_["bulk"] = {"bulk", "Allocate many same-size buddy blocks at once", bind(&CLI::handleAllocateBulk, this, _1)};
+    commands_["freeb"] = {"freeb", "Deallocate a batch of blocks", bind(&CLI::handleDeallocateBatch, this, _1)};
+    commands_["compact"] = {"compact", "Compact the physical heap", bind(&CLI::handleCompact, this, _1)};
+    commands_["reloc"] = {"reloc", "Show where a compacted block moved", bind(&CLI::handleRelocation, this, _1)};
     commands_["access"] = {"access", "Access memory location", bind(&CLI::handleAccess, this, _1)};
     commands_["dump"] = {"dump", "Display memory dump", bind(&CLI::handleDump, this, _1)};
     commands_["stats"] = {"stats", "Display system statistics", bind(&CLI::handleStats, this, _1)};
@@ -56,12 +62,27 @@ void CLI::registerCommands()
         "Toggle colored output: on | off",
         bind(&CLI::handleColor, this, _1)};
 
+    commands_["metatrace"] = {
+        "metatrace",
+        "Send allocator metadata accesses through the caches: on | off",
+        bind(&CLI::handleMetadataTrace, this, _1)};
+
+    commands_["exact"] = {
+        "exact",
+        "Trim buddy blocks to the requested size: on | off",
+        bind(&CLI::handleBuddyExact, this, _1)};
+
+    commands_["pcp"] = {
+        "pcp",
+        "Set per-process page cache watermarks: <low> <high> | off",
+        bind(&CLI::handlePageCache, this, _1)};
+
     commands_["setproc"] = {"setproc", "Set current process context", bind(&CLI::handleSetProcess, this, _1)};
     commands_["help"] = {"help", "Display help information", bind(&CLI::handleHelp, this, _1)};
     commands_["quit"] = {"quit", "Exit the simulator", bind(&CLI::handleQuit, this, _1)};
     commands_["mode"] = {
         "mode",
-        "Set allocation mode: auto | buddy | physical | forced",
+        "Set allocation mode: auto | buddy | physical | forced | slab | arena",
         bind(&CLI::handleAllocatorMode, this, _1)};
 }
 
@@ -110,11 +131,71 @@ bool CLI::handleColor(const vector<string> &args)
     return true;
 }
 
+bool CLI::handleMetadataTrace(const vector<string> &args)
+{
+    if (!memory_system_.isInitialized())
+    {
+        cout << "Error: system not initialized. Run 'init' first." << endl;
+        return false;
+    }
+
+    if (args.size() != 1 || (args[0] != "on" && args[0] != "off"))
+    {
+        cout << "Usage: metatrace on | off\n";
+        return false;
+    }
+
+    memory_system_.setMetadataTracing(args[0] == "on");
+    cout << "[INFO] Metadata tracing " << (args[0] == "on" ? "enabled" : "disabled") << "\n";
+    return true;
+}
+
+bool CLI::handleBuddyExact(const vector<string> &args)
+{
+    if (args.size() != 1 || (args[0] != "on" && args[0] != "off"))
+    {
+        cout << "Usage: exact on | off\n";
+        return false;
+    }
+
+    memory_system_.setBuddyExact(args[0] == "on");
+    cout << "[INFO] Exact buddy allocation " << (args[0] == "on" ? "enabled" : "disabled") << "\n";
+    return true;
+}
+
+bool CLI::handlePageCache(const vector<string> &args)
+{
+    if (args.size() == 1 && args[0] == "off")
+    {
+        memory_system_.setPageCacheWatermarks(0, 0);
+        cout << "[INFO] Page caches disabled\n";
+        return true;
+    }
+
+    if (args.size() != 2)
+    {
+        cout << "Usage: pcp <low> <high> | off\n";
+        return false;
+    }
+
+    size_t low = parseSize(args[0]);
+    size_t high = parseSize(args[1]);
+    if (high == 0 || low > high)
+    {
+        cout << "[ERROR] Watermarks must satisfy 0 <= low <= high, high > 0\n";
+        return false;
+    }
+
+    memory_system_.setPageCacheWatermarks(low, high);
+    cout << "[INFO] Page cache watermarks set to low " << low << ", high " << high << "\n";
+    return true;
+}
+
 bool CLI::handleAllocatorMode(const vector<string> &args)
 {
     if (args.size() != 1)
     {
-        cout << "Usage: allocator auto | buddy | physical | forced\n";
+        cout << "Usage: allocator auto | buddy | physical | forced | slab | arena\n";
         return false;
     }
 
@@ -138,9 +219,19 @@ bool CLI::handleAllocatorMode(const vector<string> &args)
         memory_system_.setAllocationMode(AllocationMode::FORCED);
         cout << "[INFO] Allocation mode set to FORCED\n";
     }
+    else if (args[0] == "slab")
+    {
+        memory_system_.setAllocationMode(AllocationMode::SLAB);
+        cout << "[INFO] Allocation mode set to SLAB\n";
+    }
+    else if (args[0] == "arena")
+    {
+        memory_system_.setAllocationMode(AllocationMode::ARENA);
+        cout << "[INFO] Allocation mode set to ARENA\n";
+    }
     else
     {
-        cout << "Unknown mode. Use auto | buddy | physical | forced\n";
+        cout << "Unknown mode. Use auto | buddy | physical | forced | slab | arena\n";
         return false;
     }
     return true;
@@ -171,6 +262,10 @@ static string allocModeToString(AllocationMode mode)
         return "PHYSICAL";
     case AllocationMode::FORCED:
         return "FORCED";
+    case AllocationMode::SLAB:
+        return "SLAB";
+    case AllocationMode::ARENA:
+        return "ARENA";
     }
     return "UNKNOWN";
 }
@@ -213,7 +308,14 @@ void CLI::printPrompt() const
 
 bool CLI::handleInit(const vector<string> &args)
 {
-    if (!memory_system_.initialize())
+    Size total_memory = args.empty() ? memory_system_.getTotalMemory() : parseSize(args[0]);
+    if (total_memory == 0)
+    {
+        cout << "Usage: init [memory size]\n";
+        return false;
+    }
+
+    if (!memory_system_.initialize(total_memory))
     {
         cout << "Failed to initialize memory system" << endl;
         return false;
@@ -273,20 +375,41 @@ bool CLI::handleAllocate(const vector<string> &args)
 
     ProcessId pid = current_process_;
     Size size = 0;
+    Size alignment = 0;
     if (pid < 0)
     {
         cout << "Error: no process selected. Use 'create' and 'setproc'." << endl;
         return false;
     }
 
-    if (args.size() == 1)
+    // Optional trailing "short" or "long" lifetime hint, after an optional
+    // "align <bytes>".
+    vector<string> sizing(args);
+    LifetimeHint lifetime = LifetimeHint::UNKNOWN;
+    if (sizing.size() >= 2 && (sizing.back() == "short" || sizing.back() == "long"))
     {
-        size = parseSize(args[0]);
+        lifetime = sizing.back() == "short" ? LifetimeHint::SHORT : LifetimeHint::LONG;
+        sizing.pop_back();
     }
-    else if (args.size() == 2)
+    if (sizing.size() >= 3 && sizing[sizing.size() - 2] == "align")
     {
-        pid = parseProcessId(args[0]);
-        size = parseSize(args[1]);
+        alignment = parseSize(sizing.back());
+        if (!isPowerOfTwo(alignment))
+        {
+            cout << "Error: alignment must be a power of two" << endl;
+            return false;
+        }
+        sizing.resize(sizing.size() - 2);
+    }
+
+    if (sizing.size() == 1)
+    {
+        size = parseSize(sizing[0]);
+    }
+    else if (sizing.size() == 2)
+    {
+        pid = parseProcessId(sizing[0]);
+        size = parseSize(sizing[1]);
     }
     else
     {
@@ -296,7 +419,7 @@ bool CLI::handleAllocate(const vector<string> &args)
     if (size == 0)
         return false;
 
-    auto result = memory_system_.allocateMemory(pid, size);
+    auto result = memory_system_.allocateMemory(pid, size, alignment, lifetime);
     if (!result.success)
     {
         cout << "Allocation failed. Did you create the process?" << endl;
@@ -326,6 +449,210 @@ bool CLI::handleDeallocate(const vector<string> &args)
     return true;
 }
 
+bool CLI::handleReallocate(const vector<string> &args)
+{
+    if (!memory_system_.isInitialized())
+    {
+        cout << "Error: system not initialized. Run 'init' first." << endl;
+        return false;
+    }
+
+    if (args.size() != 3)
+        return false;
+
+    ProcessId pid = parseProcessId(args[0]);
+    Address addr = parseAddress(args[1]);
+    Size size = parseSize(args[2]);
+    if (size == 0)
+        return false;
+
+    auto result = memory_system_.reallocate(pid, addr, size);
+    if (!result.success)
+    {
+        cout << "Realloc failed: invalid address or out of memory" << endl;
+        return false;
+    }
+
+    cout << "Resized " << formatAddress(addr) << " to " << formatSize(size);
+    if (result.address == addr)
+        cout << " in place\n";
+    else
+        cout << ", moved to " << formatAddress(result.address) << "\n";
+    return true;
+}
+
+bool CLI::handleAllocateBatch(const vector<string> &args)
+{
+    if (!memory_system_.isInitialized())
+    {
+        cout << "Error: system not initialized. Run 'init' first." << endl;
+        return false;
+    }
+
+    ProcessId pid = current_process_;
+    if (pid < 0)
+    {
+        cout << "Error: no process selected. Use 'create' and 'setproc'." << endl;
+        return false;
+    }
+    if (args.empty())
+        return false;
+
+    vector<Size> sizes;
+    for (const auto &arg : args)
+    {
+        Size size = parseSize(arg);
+        if (size == 0)
+            return false;
+        sizes.push_back(size);
+    }
+
+    auto results = memory_system_.allocateBatch(pid, sizes);
+    size_t ok = count_if(results.begin(), results.end(),
+                         [](const AllocationResult &r) { return r.success; });
+
+    cout << "Allocated " << ok << " / " << results.size() << " blocks:";
+    for (const auto &r : results)
+    {
+        if (r.success)
+            cout << " " << formatAddress(r.address);
+        else
+            cout << " failed";
+    }
+    cout << "\n";
+    return ok == results.size();
+}
+
+bool CLI::handleAllocateBulk(const vector<string> &args)
+{
+    if (!memory_system_.isInitialized())
+    {
+        cout << "Error: system not initialized. Run 'init' first." << endl;
+        return false;
+    }
+
+    ProcessId pid = current_process_;
+    if (pid < 0)
+    {
+        cout << "Error: no process selected. Use 'create' and 'setproc'." << endl;
+        return false;
+    }
+    if (args.size() != 2)
+    {
+        cout << "Usage: bulk <count> <size>\n";
+        return false;
+    }
+
+    size_t count = parseSize(args[0]);
+    Size size = parseSize(args[1]);
+    if (count == 0 || size == 0)
+        return false;
+
+    auto addresses = memory_system_.allocateBulk(pid, size, count);
+    cout << "Allocated " << addresses.size() << " / " << count << " blocks of "
+         << formatSize(nextPowerOfTwo(size)) << ":";
+    for (Address address : addresses)
+    {
+        cout << " " << formatAddress(address);
+    }
+    cout << "\n";
+    return addresses.size() == count;
+}
+
+bool CLI::handleDeallocateBatch(const vector<string> &args)
+{
+    if (!memory_system_.isInitialized())
+    {
+        cout << "Error: system not initialized. Run 'init' first." << endl;
+        return false;
+    }
+
+    if (args.size() < 2)
+        return false;
+
+    ProcessId pid = parseProcessId(args[0]);
+    vector<Address> addresses;
+    for (size_t i = 1; i < args.size(); ++i)
+    {
+        addresses.push_back(parseAddress(args[i]));
+    }
+
+    size_t freed = memory_system_.deallocateBatch(pid, addresses);
+    cout << "Freed " << freed << " / " << addresses.size() << " blocks\n";
+    return freed == addresses.size();
+}
+
+bool CLI::handleCompact(const vector<string> &args)
+{
+    if (!memory_system_.isInitialized())
+    {
+        cout << "Error: system not initialized. Run 'init' first." << endl;
+        return false;
+    }
+
+    if (args.size() == 1 && args[0] == "off")
+    {
+        memory_system_.setAutoCompaction(0.0, 0);
+        cout << "[INFO] Automatic compaction disabled\n";
+        return true;
+    }
+
+    if (args.size() == 3 && args[0] == "auto")
+    {
+        double threshold = 0.0;
+        try
+        {
+            threshold = stod(args[1]) / 100.0;
+        }
+        catch (...)
+        {
+            return false;
+        }
+        Size step = parseSize(args[2]);
+        if (threshold <= 0.0 || step == 0)
+            return false;
+
+        memory_system_.setAutoCompaction(threshold, step);
+        cout << "[INFO] Compacting " << formatSize(step)
+             << " per operation while fragmentation > " << args[1] << " %\n";
+        return true;
+    }
+
+    Size step = 0;
+    if (args.size() == 2 && args[0] == "step")
+        step = parseSize(args[1]);
+    else if (!args.empty())
+        return false;
+
+    auto moved = memory_system_.compactHeap(step);
+    Size bytes = 0;
+    for (const auto &r : moved)
+        bytes += r.size;
+
+    cout << "Compaction moved " << moved.size() << " blocks ("
+         << formatSize(bytes) << ")\n";
+    for (const auto &r : moved)
+    {
+        cout << "  " << formatAddress(r.old_address) << " -> "
+             << formatAddress(r.new_address) << "  P" << r.process_id << "\n";
+    }
+    return true;
+}
+
+bool CLI::handleRelocation(const vector<string> &args)
+{
+    if (args.size() != 1)
+        return false;
+
+    Address address = parseAddress(args[0]);
+    Address current = memory_system_.resolveRelocation(address);
+    if (current == address)
+        cout << formatAddress(address) << " has not moved\n";
+    else
+        cout << formatAddress(address) << " -> " << formatAddress(current) << "\n";
+    return true;
+}
+
 bool CLI::handleAccess(const vector<string> &args)
 {
     if (!memory_system_.isInitialized())
@@ -411,6 +738,82 @@ bool CLI::handleStats(const vector<string> &args)
          << phys.allocation_failures << "\n";
     cout << "  Utilization           : "
          << phys.memory_utilization * 100 << " %\n";
+    cout << "  Avg Scan Length       : "
+         << (phys.allocation_requests
+                 ? static_cast<double>(phys.blocks_scanned) / phys.allocation_requests
+                 : 0.0)
+         << " blocks (max " << phys.longest_scan << ")\n";
+    if (phys.realloc_in_place + phys.realloc_moved > 0)
+    {
+        cout << "  Realloc In Place/Moved: "
+             << phys.realloc_in_place << " / " << phys.realloc_moved
+             << " (" << formatSize(phys.realloc_bytes_copied) << " copied)\n";
+    }
+    if (phys.aligned_allocations > 0)
+    {
+        cout << "  Aligned Allocations   : " << phys.aligned_allocations
+             << " (" << formatSize(phys.alignment_waste) << " padding)\n";
+    }
+
+    // ---------------- ptmalloc Bins ----------------
+    if (memory_system_.getAllocationStrategy() == AllocationStrategy::PTMALLOC)
+    {
+        auto bins = memory_system_.getPtmallocStats();
+        const char *names[] = {"tcache", "fastbins", "smallbins", "largebins", "top chunk"};
+
+        cout << Color::blue() << "\n[ptmalloc Bins]\n"
+             << Color::reset();
+        for (int t = 0; t < PtmallocAllocator::TIER_COUNT; ++t)
+        {
+            cout << "  " << left << setw(22) << names[t] << ": "
+                 << bins.hits[t] << " / " << bins.lookups[t] << " hits";
+            if (bins.lookups[t] > 0)
+                cout << " (" << 100.0 * bins.hits[t] / bins.lookups[t] << " %)";
+            cout << "\n";
+        }
+        cout << "  Skipped Bin Search    : " << bins.fast_path
+             << " of " << phys.allocation_requests << " requests\n";
+        cout << "  Cached Chunks         : " << bins.cached_chunks
+             << " (" << formatSize(bins.cached_bytes) << ")\n";
+        cout << "  Consolidations        : " << bins.consolidations << "\n";
+        cout << "  Heap Top (brk)        : " << formatAddress(bins.heap_top)
+             << " (" << bins.top_extensions << " extensions)\n";
+    }
+
+    // ---------------- Lifetime Placement ----------------
+    if (memory_system_.getAllocationStrategy() == AllocationStrategy::LIFETIME)
+    {
+        auto life = memory_system_.getLifetimeStats();
+
+        cout << Color::blue() << "\n[Lifetime Placement]\n"
+             << Color::reset();
+        cout << "  Hinted Requests       : " << life.hinted << "\n";
+        cout << "  Predicted Short / Long: "
+             << life.predicted_short << " / " << life.predicted_long << "\n";
+        cout << "  Prediction Accuracy   : " << life.predictions_correct
+             << " / " << life.predictions_checked << " correct\n";
+        cout << "  Placed At Top         : " << life.short_placements << "\n";
+    }
+
+    // ---------------- Allocator Metadata ----------------
+    auto meta = memory_system_.getMetadataTrafficStats();
+    if (meta.enabled)
+    {
+        cout << Color::blue() << "\n[Allocator Metadata]\n"
+             << Color::reset();
+        cout << "  Accesses              : " << meta.accesses << "\n";
+        cout << "  Cache Misses          : " << meta.misses << "\n";
+        cout << "  Allocations           : " << meta.allocations << "\n";
+        if (meta.allocations > 0)
+        {
+            cout << fixed << setprecision(2)
+                 << "  Per Allocation        : "
+                 << static_cast<double>(meta.accesses) / meta.allocations << " accesses, "
+                 << static_cast<double>(meta.misses) / meta.allocations << " misses\n";
+            cout.unsetf(ios::fixed);
+            cout << setprecision(6);
+        }
+    }
 
     // ---------------- Buddy Allocator ----------------
     auto buddy = memory_system_.getBuddyAllocatorStats();
@@ -428,6 +831,76 @@ bool CLI::handleStats(const vector<string> &args)
          << buddy.allocation_failures << "\n";
     cout << "  Utilization           : "
          << buddy.memory_utilization * 100 << " %\n";
+    if (buddy.realloc_in_place + buddy.realloc_moved > 0)
+    {
+        cout << "  Realloc In Place/Moved: "
+             << buddy.realloc_in_place << " / " << buddy.realloc_moved
+             << " (" << formatSize(buddy.realloc_bytes_copied) << " copied)\n";
+    }
+    if (buddy.aligned_allocations > 0)
+    {
+        cout << "  Aligned Allocations   : " << buddy.aligned_allocations
+             << " (" << formatSize(buddy.alignment_waste) << " padding)\n";
+    }
+    if (buddy.exact_allocations > 0)
+    {
+        cout << "  Exact Allocations     : " << buddy.exact_allocations
+             << " (" << formatSize(buddy.exact_trimmed) << " trimmed)\n";
+    }
+
+    // ---------------- Page Caches ----------------
+    auto pcp = memory_system_.getPageCacheStats();
+    if (pcp.allocations + pcp.frees > 0)
+    {
+        cout << Color::blue() << "\n[Page Caches]\n"
+             << Color::reset();
+        cout << "  Allocations From Cache: " << pcp.allocation_hits
+             << " / " << pcp.allocations << "\n";
+        cout << "  Frees Kept In Cache   : " << pcp.free_hits
+             << " / " << pcp.frees << "\n";
+        cout << "  Refills (pages)       : " << pcp.refills
+             << " (" << pcp.pages_refilled << ")\n";
+        cout << "  Drains (pages)        : " << pcp.drains
+             << " (" << pcp.pages_drained << ")\n";
+        cout << "  Cached / In Use       : " << pcp.cached_pages
+             << " / " << pcp.pages_in_use << " pages\n";
+    }
+
+    // ---------------- Slab Caches ----------------
+    auto slab = memory_system_.getSlabAllocatorStats();
+    if (slab.allocation_requests > 0)
+    {
+        cout << Color::blue() << "\n[Slab Caches]\n"
+             << Color::reset();
+        cout << "  Slab Memory           : " << formatSize(slab.total_memory) << "\n";
+        cout << "  Objects In Use        : " << slab.allocated_blocks
+             << " (" << formatSize(slab.used_memory) << ")\n";
+        cout << "  Internal Fragmentation: "
+             << Color::yellow()
+             << formatSize(slab.internal_fragmentation)
+             << Color::reset() << "\n";
+        cout << "  Requests              : " << slab.allocation_requests << "\n";
+        cout << "  Success / Failure     : "
+             << slab.allocation_successes << " / "
+             << slab.allocation_failures << "\n";
+        if (slab.realloc_moved > 0)
+        {
+            cout << "  Realloc Moved         : " << slab.realloc_moved
+                 << " (" << formatSize(slab.realloc_bytes_copied) << " copied)\n";
+        }
+
+        for (const auto &c : memory_system_.getSlabCacheInfo())
+        {
+            if (c.full_slabs + c.partial_slabs + c.empty_slabs == 0)
+                continue;
+            cout << "  " << left << setw(22)
+                 << ("size-" + to_string(c.object_size))
+                 << ": " << c.active_objects << " objs, slabs "
+                 << c.full_slabs << " full / "
+                 << c.partial_slabs << " partial / "
+                 << c.empty_slabs << " empty\n";
+        }
+    }
 
     // ---------------- Virtual Memory ----------------
     auto vmm = memory_system_.getVMMStats();
@@ -516,6 +989,54 @@ bool CLI::handleBenchmark(const vector<string> &args)
     {
         memory_system_.benchmarkCachePerformance();
     }
+    else if (args[0] == "scale")
+    {
+        size_t max_blocks = args.size() > 1 ? parseSize(args[1]) : 16000;
+        memory_system_.benchmarkAllocationScaling(max_blocks);
+    }
+    else if (args[0] == "scan")
+    {
+        size_t max_blocks = args.size() > 1 ? parseSize(args[1]) : 1000000;
+        memory_system_.benchmarkFitScan(max_blocks);
+    }
+    else if (args[0] == "latency")
+    {
+        memory_system_.benchmarkAllocationLatency();
+    }
+    else if (args[0] == "small")
+    {
+        memory_system_.benchmarkSmallObjects();
+    }
+    else if (args[0] == "batch")
+    {
+        memory_system_.benchmarkBatchReplay();
+    }
+    else if (args[0] == "align")
+    {
+        size_t objects = args.size() > 1 ? parseSize(args[1]) : 4096;
+        memory_system_.benchmarkAlignment(objects);
+    }
+    else if (args[0] == "lifetime")
+    {
+        size_t operations = args.size() > 1 ? parseSize(args[1]) : 200000;
+        memory_system_.benchmarkLifetimePlacement(operations);
+    }
+    else if (args[0] == "meta")
+    {
+        size_t operations = args.size() > 1 ? parseSize(args[1]) : 50000;
+        memory_system_.benchmarkMetadataTraffic(operations);
+    }
+    else if (args[0] == "threads")
+    {
+        size_t max_threads = args.size() > 1 ? parseSize(args[1]) : 0;
+        bool buddy = args.size() > 2 && args[2] == "buddy";
+        memory_system_.benchmarkConcurrentScaling(max_threads, buddy);
+    }
+    else if (args[0] == "teardown")
+    {
+        size_t max_objects = args.size() > 1 ? parseSize(args[1]) : 32000;
+        memory_system_.benchmarkProcessTeardown(max_objects);
+    }
     else
     {
         return false;
@@ -596,7 +1117,7 @@ void CLI::printHelp() const
          << "\n================ AVAILABLE COMMANDS ================\n"
          << Color::reset();
 
-    section("System", {{"init", "Initialize memory system"},
+    section("System", {{"init [size]", "Initialize memory system (B / KB / MB / GB / TB)"},
                        {"quit", "Exit simulator"},
                        {"help", "Show this help"}});
 
@@ -605,17 +1126,30 @@ void CLI::printHelp() const
                         {"terminate <pid>", "Terminate a process"},
                         {"process [pid]", "Show process information"}});
 
-    section("Memory Allocation", {{"alloc <size>", "Allocate memory (B / KB / MB)"},
+    section("Memory Allocation", {{"alloc <size>", "Allocate memory (B / KB / MB / GB)"},
+                                  {"alloc <size> align <bytes>", "Allocate at a power-of-two boundary"},
+                                  {"alloc <size> [align <bytes>] short|long", "Allocate with a lifetime hint"},
                                   {"free <pid> <addr>", "Free allocated memory"},
-                                  {"mode <auto|buddy|physical|forced>", "Set allocation mode"},
-                                  {"strategy <first|best|worst>", "Set physical allocation strategy"}});
+                                  {"realloc <pid> <addr> <size>", "Resize a block, in place when possible"},
+                                  {"allocb <size>...", "Allocate several blocks in one batch"},
+                                  {"bulk <count> <size>", "Allocate many same-size buddy blocks at once"},
+                                  {"freeb <pid> <addr>...", "Free several blocks in one batch"},
+                                  {"compact [step <bytes>]", "Slide allocated blocks together"},
+                                  {"compact auto <pct> <bytes>", "Compact incrementally above a fragmentation %"},
+                                  {"compact off", "Disable automatic compaction"},
+                                  {"reloc <addr>", "Show where a compacted block moved"},
+                                  {"mode <auto|buddy|physical|forced|slab|arena>", "Set allocation mode"},
+                                  {"exact <on|off>", "Trim buddy blocks to the requested size"},
+                                  {"pcp <low> <high>|off", "Set per-process page cache watermarks"},
+                                  {"strategy <first|best|worst|next|tlsf|bitmap|ptmalloc|lifetime>", "Set physical allocation strategy"}});
 
     section("Virtual Memory", {{"access <addr> [write]", "Access virtual address"},
                                {"policy <fifo|lru|clock>", "Set page replacement policy"}});
 
     section("Inspection", {{"dump", "Dump physical memory layout"},
                            {"stats", "Show system statistics"},
-                           {"bench [alloc|cache]", "Run benchmarks"},
+                           {"metatrace <on|off>", "Trace allocator metadata through the caches"},
+                           {"bench [alloc|cache|scale|scan|latency|small|teardown|threads|batch|align|lifetime|meta]", "Run benchmarks"},
                            {"test [name]", "Run memory tests"}});
 
     section("UI / UX", {{"color <on|off>", "Toggle colored output"}});
@@ -641,11 +1175,11 @@ Address CLI::parseAddress(const string &str) const
 {
     if (str.substr(0, 2) == "0x")
     {
-        return stoul(str.substr(2), nullptr, 16);
+        return stoull(str.substr(2), nullptr, 16);
     }
     try
     {
-        return stoul(str);
+        return stoull(str);
     }
     catch (...)
     {
@@ -671,6 +1205,16 @@ Size CLI::parseSize(const string &str) const
         multiplier = 1024 * 1024;
         s = s.substr(0, s.size() - 2);
     }
+    else if (s.size() >= 2 && s.substr(s.size() - 2) == "gb")
+    {
+        multiplier = Size(1) << 30;
+        s = s.substr(0, s.size() - 2);
+    }
+    else if (s.size() >= 2 && s.substr(s.size() - 2) == "tb")
+    {
+        multiplier = Size(1) << 40;
+        s = s.substr(0, s.size() - 2);
+    }
     else if (s.back() == 'b')
     {
         s.pop_back();
@@ -694,6 +1238,16 @@ AllocationStrategy CLI::parseAllocationStrategy(const string &str) const
         return AllocationStrategy::BEST_FIT;
     if (str == "worst")
         return AllocationStrategy::WORST_FIT;
+    if (str == "next")
+        return AllocationStrategy::NEXT_FIT;
+    if (str == "tlsf")
+        return AllocationStrategy::TLSF;
+    if (str == "bitmap")
+        return AllocationStrategy::BITMAP;
+    if (str == "ptmalloc")
+        return AllocationStrategy::PTMALLOC;
+    if (str == "lifetime")
+        return AllocationStrategy::LIFETIME;
     return AllocationStrategy::FIRST_FIT;
 }
 
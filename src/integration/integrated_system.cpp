@@ -2,11 +2,21 @@
 #include "allocator/first_fit.hpp"
 #include "allocator/best_fit.hpp"
 #include "allocator/worst_fit.hpp"
+#include "allocator/next_fit.hpp"
+#include "allocator/tlsf.hpp"
+#include "allocator/bitmap_allocator.hpp"
+#include "allocator/ptmalloc.hpp"
+#include "allocator/lifetime_allocator.hpp"
+#include "allocator/thread_caching_allocator.hpp"
 #include "common/utils.hpp"
 #include "common/colors.hpp"
 #include <iostream>
 #include <iomanip>
 #include <algorithm>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <map>
 
 using namespace std;
 
@@ -21,10 +31,20 @@ IntegratedMemorySystem::IntegratedMemorySystem(
       allocation_mode_(AllocationMode::AUTO),
       page_replacement_policy_(page_policy),
       initialized_(false),
+      compaction_threshold_(0.0),
+      compaction_step_bytes_(0),
+      buddy_exact_(false),
+      page_cache_low_(PageCache::DEFAULT_LOW),
+      page_cache_high_(PageCache::DEFAULT_HIGH),
+      retired_page_cache_stats_{},
       total_operations_(0),
       cache_hits_(0),
       cache_misses_(0),
-      page_faults_(0)
+      page_faults_(0),
+      metadata_tracing_(false),
+      metadata_accesses_(0),
+      metadata_misses_(0),
+      metadata_allocations_(0)
 {
 }
 
@@ -35,15 +55,20 @@ bool IntegratedMemorySystem::initialize()
         physical_allocator_ = createAllocator(alloc_strategy_, total_memory_);
         physical_allocator_->initialize(total_memory_);
         allocation_mode_ = AllocationMode::AUTO;
+        slab_realloc_moves_ = ReallocMoves();
+        arena_realloc_moves_ = ReallocMoves();
+        page_realloc_moves_ = ReallocMoves();
 
-        Size buddy_memory = total_memory_ / 2;
-        if (!isPowerOfTwo(buddy_memory))
-        {
-            buddy_memory = nextPowerOfTwo(buddy_memory);
-        }
-
-        buddy_allocator_ = make_unique<BuddyAllocator>(buddy_memory);
+        buddy_allocator_ = make_unique<BuddyAllocator>(total_memory_ / 2);
         buddy_allocator_->initialize();
+        // Page-cache counters start over with the buddy allocator's.
+        for (auto &p : process_allocations_)
+            p.second.pages = PageCache(page_size_, p.first, page_cache_low_, page_cache_high_);
+        retired_page_cache_stats_ = PageCache::Stats{};
+
+        // Slabs are carved from buddy pages, one VM page per slab.
+        slab_allocator_ = make_unique<SlabAllocator>(*buddy_allocator_, page_size_);
+        slab_allocator_->setReclaimer([this]() { return drainPageCaches(); });
 
         cache_hierarchy_ = make_unique<CacheHierarchy>(
             32768, 262144, 2097152,
@@ -57,6 +82,7 @@ bool IntegratedMemorySystem::initialize()
             page_size_,
             page_replacement_policy_);
 
+        attachMetadataObservers();
         initialized_ = true;
         return true;
     }
@@ -69,6 +95,12 @@ bool IntegratedMemorySystem::initialize()
     }
 }
 
+bool IntegratedMemorySystem::initialize(Size total_memory)
+{
+    total_memory_ = total_memory;
+    return initialize();
+}
+
 unique_ptr<BaseAllocator>
 IntegratedMemorySystem::createAllocator(AllocationStrategy strategy, Size memory_size)
 {
@@ -80,6 +112,16 @@ IntegratedMemorySystem::createAllocator(AllocationStrategy strategy, Size memory
         return make_unique<BestFitAllocator>(memory_size);
     case AllocationStrategy::WORST_FIT:
         return make_unique<WorstFitAllocator>(memory_size);
+    case AllocationStrategy::NEXT_FIT:
+        return make_unique<NextFitAllocator>(memory_size);
+    case AllocationStrategy::TLSF:
+        return make_unique<TlsfAllocator>(memory_size);
+    case AllocationStrategy::BITMAP:
+        return make_unique<BitmapAllocator>(memory_size);
+    case AllocationStrategy::PTMALLOC:
+        return make_unique<PtmallocAllocator>(memory_size);
+    case AllocationStrategy::LIFETIME:
+        return make_unique<LifetimeAllocator>(memory_size);
     default:
         return make_unique<FirstFitAllocator>(memory_size);
     }
@@ -89,7 +131,8 @@ bool IntegratedMemorySystem::createProcess(ProcessId process_id)
 {
     if (process_allocations_.count(process_id))
         return false;
-    process_allocations_[process_id] = vector<Address>();
+    process_allocations_[process_id] = ProcessAllocations();
+    process_allocations_[process_id].pages = PageCache(page_size_, process_id, page_cache_low_, page_cache_high_);
     return virtual_memory_manager_->createProcess(process_id);
 }
 
@@ -99,16 +142,57 @@ bool IntegratedMemorySystem::terminateProcess(ProcessId process_id)
     if (it == process_allocations_.end())
         return false;
 
-    for (Address addr : it->second)
+    // Moved objects of this process are about to be freed.
+    vector<Address> moved;
+    for (const auto &r : relocated_from_)
     {
-        deallocateMemory(process_id, addr);
+        if (it->second.physical.count(r.first) || it->second.arena.owns(r.first))
+            moved.push_back(r.first);
     }
+    for (Address address : moved)
+        forgetRelocations(address);
+
+    // Arena objects go back a chunk at a time, not one by one.
+    it->second.arena.releaseAll(*physical_allocator_, process_id);
+
+    for (Address addr : it->second.slab)
+    {
+        slab_allocator_->deallocate(addr);
+    }
+
+    retirePageCache(it->second.pages);
+    it->second.pages.releaseAll(*buddy_allocator_);
+    buddy_allocator_->deallocateBatch(
+        vector<Address>(it->second.buddy.begin(), it->second.buddy.end()));
+    physical_allocator_->deallocateBatch(
+        vector<Address>(it->second.physical.begin(), it->second.physical.end()),
+        process_id);
 
     process_allocations_.erase(it);
     return virtual_memory_manager_->terminateProcess(process_id);
 }
 
-AllocationResult IntegratedMemorySystem::allocateMemory(ProcessId process_id, Size size)
+IntegratedMemorySystem::AllocationTarget IntegratedMemorySystem::selectTarget(Size size, Size alignment) const
+{
+    switch (allocation_mode_)
+    {
+    case AllocationMode::ARENA:
+        return alignment <= ProcessArena::ALIGNMENT ? AllocationTarget::ARENA : AllocationTarget::PHYSICAL;
+    case AllocationMode::SLAB:
+        return SlabAllocator::handles(size) && alignment <= SlabAllocator::OBJECT_ALIGNMENT
+                   ? AllocationTarget::SLAB
+                   : AllocationTarget::PHYSICAL;
+    case AllocationMode::BUDDY:
+        return AllocationTarget::BUDDY;
+    case AllocationMode::AUTO:
+        return isPowerOfTwo(size) ? AllocationTarget::BUDDY : AllocationTarget::PHYSICAL;
+    default:
+        return AllocationTarget::PHYSICAL;
+    }
+}
+
+AllocationResult IntegratedMemorySystem::allocateMemory(ProcessId process_id, Size size, Size alignment,
+                                                        LifetimeHint lifetime)
 {
     if (!initialized_)
         return AllocationResult(false, 0, -1);
@@ -119,36 +203,173 @@ AllocationResult IntegratedMemorySystem::allocateMemory(ProcessId process_id, Si
     if (it == process_allocations_.end())
         return AllocationResult(false, 0, -1);
 
-    bool use_buddy = false;
+    switch (selectTarget(size, alignment))
+    {
+    case AllocationTarget::ARENA:
+    {
+        auto result = it->second.arena.allocate(*physical_allocator_, {size, process_id});
+        if (result.success)
+            forgetRelocations(result.address);
+        maybeCompact();
+        return result;
+    }
 
-    if (allocation_mode_ == AllocationMode::BUDDY)
-        use_buddy = true;
-    else if (allocation_mode_ == AllocationMode::PHYSICAL)
-        use_buddy = false;
-    else if (allocation_mode_ == AllocationMode::AUTO)
-        use_buddy = isPowerOfTwo(size);
+    case AllocationTarget::SLAB:
+    {
+        auto result = slab_allocator_->allocate({size, process_id});
+        if (result.success)
+            it->second.slab.insert(result.address);
+        return result;
+    }
 
-    if (use_buddy)
+    case AllocationTarget::BUDDY:
     {
+        if (metadata_tracing_)
+            metadata_allocations_++;
         cout << "[INFO] Buddy allocator selected (power-of-two request)\n";
-        auto result = buddy_allocator_->allocate({size, process_id});
+
+        // Whole pages come from the process's page cache. When the buddy
+        // allocator runs dry, the other caches give their free pages back
+        // and the request is tried once more.
+        PageCache &pages = it->second.pages;
+        if (size == page_size_ && alignment <= page_size_ && !buddy_exact_ && pages.enabled())
+        {
+            auto result = pages.allocate(*buddy_allocator_);
+            if (!result.success && drainPageCaches() > 0)
+                result = pages.allocate(*buddy_allocator_);
+            return result;
+        }
+
+        auto allocate = [&]()
+        {
+            return buddy_exact_
+                       ? buddy_allocator_->allocateExact({size, process_id, alignment})
+                       : buddy_allocator_->allocate({size, process_id, alignment});
+        };
+        auto result = allocate();
+        if (!result.success && drainPageCaches() > 0)
+            result = allocate();
         if (result.success)
-            it->second.push_back(result.address);
+            it->second.buddy.insert(result.address);
         return result;
     }
 
-    auto result = physical_allocator_->allocate({size, process_id});
+    default:
+        break;
+    }
+
+    if (metadata_tracing_)
+        metadata_allocations_++;
+    auto result = physical_allocator_->allocate({size, process_id, alignment, lifetime});
     if (result.success)
-        it->second.push_back(result.address);
+    {
+        it->second.physical.insert(result.address);
+        forgetRelocations(result.address);
+    }
 
+    maybeCompact();
     return result;
 }
 
+vector<AllocationResult> IntegratedMemorySystem::allocateBatch(ProcessId process_id, const vector<Size> &sizes)
+{
+    vector<AllocationResult> results(sizes.size());
+    if (!initialized_)
+        return results;
+
+    auto it = process_allocations_.find(process_id);
+    if (it == process_allocations_.end())
+        return results;
+
+    total_operations_ += sizes.size();
+    auto &allocs = it->second;
+
+    // Group requests by back end so each allocator sees one batch call.
+    vector<size_t> buddy_slots, physical_slots;
+    vector<Size> buddy_sizes, physical_sizes;
+
+    for (size_t i = 0; i < sizes.size(); ++i)
+    {
+        switch (selectTarget(sizes[i]))
+        {
+        case AllocationTarget::ARENA:
+            results[i] = allocs.arena.allocate(*physical_allocator_, {sizes[i], process_id});
+            if (results[i].success)
+                forgetRelocations(results[i].address);
+            break;
+        case AllocationTarget::SLAB:
+            results[i] = slab_allocator_->allocate({sizes[i], process_id});
+            if (results[i].success)
+                allocs.slab.insert(results[i].address);
+            break;
+        case AllocationTarget::BUDDY:
+            buddy_slots.push_back(i);
+            buddy_sizes.push_back(sizes[i]);
+            break;
+        default:
+            physical_slots.push_back(i);
+            physical_sizes.push_back(sizes[i]);
+            break;
+        }
+    }
+
+    if (metadata_tracing_)
+        metadata_allocations_ += buddy_sizes.size() + physical_sizes.size();
+
+    if (!buddy_sizes.empty())
+    {
+        cout << "[INFO] Buddy allocator selected for "
+             << buddy_sizes.size() << " power-of-two requests\n";
+        auto batch = buddy_allocator_->allocateBatch(buddy_sizes, process_id, buddy_exact_);
+        for (size_t k = 0; k < batch.size(); ++k)
+        {
+            results[buddy_slots[k]] = batch[k];
+            if (batch[k].success)
+                allocs.buddy.insert(batch[k].address);
+        }
+    }
+
+    if (!physical_sizes.empty())
+    {
+        auto batch = physical_allocator_->allocateBatch(physical_sizes, process_id);
+        for (size_t k = 0; k < batch.size(); ++k)
+        {
+            results[physical_slots[k]] = batch[k];
+            if (batch[k].success)
+            {
+                allocs.physical.insert(batch[k].address);
+                forgetRelocations(batch[k].address);
+            }
+        }
+    }
+
+    return results;
+}
+
 void IntegratedMemorySystem::setAllocationMode(AllocationMode mode)
 {
     allocation_mode_ = mode;
 }
 
+vector<Address> IntegratedMemorySystem::allocateBulk(ProcessId process_id, Size block_size, size_t count)
+{
+    if (!initialized_ || block_size == 0)
+        return {};
+
+    auto it = process_allocations_.find(process_id);
+    if (it == process_allocations_.end())
+        return {};
+
+    total_operations_ += count;
+    if (metadata_tracing_)
+        metadata_allocations_ += count;
+
+    int order = log2Floor(nextPowerOfTwo(block_size));
+    auto addresses = buddy_allocator_->allocateBulk(order, count, process_id);
+    it->second.buddy.insert(addresses.begin(), addresses.end());
+    return addresses;
+}
+
 bool IntegratedMemorySystem::deallocateMemory(ProcessId process_id, Address address)
 {
     if (!initialized_)
@@ -160,31 +381,180 @@ bool IntegratedMemorySystem::deallocateMemory(ProcessId process_id, Address addr
 
     auto &allocs = pit->second;
 
-    if (find(allocs.begin(), allocs.end(), address) == allocs.end())
-        return false;
+    if (allocs.arena.owns(address))
+    {
+        if (!allocs.arena.deallocate(*physical_allocator_, address, process_id))
+            return false;
+        forgetRelocations(address);
+        maybeCompact();
+        return true;
+    }
 
-    if (buddy_allocator_ && buddy_allocator_->deallocate(address))
+    if (allocs.slab.count(address))
     {
-        allocs.erase(remove(allocs.begin(), allocs.end(), address), allocs.end());
+        if (!slab_allocator_->deallocate(address))
+            return false;
+        allocs.slab.erase(address);
         return true;
     }
 
-    const auto &blocks = physical_allocator_->getBlocks();
-    for (const auto &block : blocks)
+    if (allocs.pages.owns(address))
+        return allocs.pages.deallocate(*buddy_allocator_, address);
+
+    if (allocs.buddy.count(address))
+    {
+        if (!buddy_allocator_->deallocate(address))
+            return false;
+        allocs.buddy.erase(address);
+        return true;
+    }
+
+    if (allocs.physical.count(address))
+    {
+        if (!physical_allocator_->deallocateAddress(address, process_id))
+            return false;
+        allocs.physical.erase(address);
+        forgetRelocations(address);
+        maybeCompact();
+        return true;
+    }
+
+    return false;
+}
+
+size_t IntegratedMemorySystem::deallocateBatch(ProcessId process_id, const vector<Address> &addresses)
+{
+    if (!initialized_)
+        return 0;
+
+    auto pit = process_allocations_.find(process_id);
+    if (pit == process_allocations_.end())
+        return 0;
+
+    auto &allocs = pit->second;
+    size_t freed = 0;
+    vector<Address> buddy_batch, physical_batch;
+
+    for (Address address : addresses)
     {
-        if (block.start_address == address &&
-            block.status == BlockStatus::ALLOCATED &&
-            block.process_id == process_id)
+        if (allocs.arena.owns(address))
         {
-            if (physical_allocator_->deallocate(block.block_id))
+            if (allocs.arena.deallocate(*physical_allocator_, address, process_id))
             {
-                allocs.erase(remove(allocs.begin(), allocs.end(), address), allocs.end());
-                return true;
+                forgetRelocations(address);
+                freed++;
             }
         }
+        else if (allocs.slab.count(address))
+        {
+            if (slab_allocator_->deallocate(address))
+                freed++;
+            allocs.slab.erase(address);
+        }
+        else if (allocs.pages.owns(address))
+        {
+            if (allocs.pages.deallocate(*buddy_allocator_, address))
+                freed++;
+        }
+        else if (allocs.buddy.count(address))
+        {
+            buddy_batch.push_back(address);
+        }
+        else if (allocs.physical.count(address))
+        {
+            physical_batch.push_back(address);
+        }
     }
 
-    return false;
+    freed += buddy_allocator_->deallocateBatch(buddy_batch);
+    for (Address address : buddy_batch)
+        allocs.buddy.erase(address);
+
+    freed += physical_allocator_->deallocateBatch(physical_batch, process_id);
+    for (Address address : physical_batch)
+    {
+        allocs.physical.erase(address);
+        forgetRelocations(address);
+    }
+
+    return freed;
+}
+
+AllocationResult IntegratedMemorySystem::reallocate(ProcessId process_id, Address address, Size new_size)
+{
+    if (!initialized_ || new_size == 0)
+        return AllocationResult(false, 0, -1);
+
+    auto pit = process_allocations_.find(process_id);
+    if (pit == process_allocations_.end())
+        return AllocationResult(false, 0, -1);
+
+    auto &allocs = pit->second;
+
+    if (allocs.physical.count(address))
+    {
+        total_operations_++;
+        auto result = physical_allocator_->reallocate(address, new_size, process_id);
+        if (result.success && result.address != address)
+        {
+            allocs.physical.erase(address);
+            allocs.physical.insert(result.address);
+            forgetRelocations(address);
+            forgetRelocations(result.address);
+        }
+        if (result.success)
+            maybeCompact();
+        return result;
+    }
+
+    if (allocs.buddy.count(address))
+    {
+        total_operations_++;
+        auto result = buddy_allocator_->reallocate(address, new_size);
+        if (result.success && result.address != address)
+        {
+            allocs.buddy.erase(address);
+            allocs.buddy.insert(result.address);
+        }
+        return result;
+    }
+
+    // Slab objects, arena objects and cached pages have fixed slots:
+    // always move, keeping the alignment the slot had.
+    ReallocMoves *moves;
+    Size old_size;
+    Size alignment;
+    if (allocs.slab.count(address))
+    {
+        moves = &slab_realloc_moves_;
+        old_size = slab_allocator_->objectSize(address);
+        alignment = SlabAllocator::OBJECT_ALIGNMENT;
+    }
+    else if (allocs.arena.owns(address))
+    {
+        moves = &arena_realloc_moves_;
+        old_size = allocs.arena.objectSize(address);
+        alignment = ProcessArena::ALIGNMENT;
+    }
+    else if (allocs.pages.owns(address))
+    {
+        moves = &page_realloc_moves_;
+        old_size = page_size_;
+        alignment = page_size_;
+    }
+    else
+    {
+        return AllocationResult(false, 0, -1);
+    }
+
+    auto result = allocateMemory(process_id, new_size, alignment);
+    if (result.success)
+    {
+        deallocateMemory(process_id, address);
+        moves->moved++;
+        moves->bytes_copied += min(old_size, new_size);
+    }
+    return result;
 }
 
 bool IntegratedMemorySystem::accessMemory(ProcessId process_id, Address virtual_address, bool is_write)
@@ -222,10 +592,203 @@ void IntegratedMemorySystem::switchAllocationStrategy(AllocationStrategy new_str
 
     physical_allocator_ = createAllocator(new_strategy, total_memory_);
     physical_allocator_->initialize(total_memory_);
+    attachMetadataObservers();
+    arena_realloc_moves_ = ReallocMoves();
+
+    // The old heap is gone, so its addresses are no longer owned by anyone.
+    for (auto &p : process_allocations_)
+    {
+        p.second.physical.clear();
+        p.second.arena.reset();
+    }
+    relocated_to_.clear();
+    relocated_from_.clear();
 
     cout << "[INFO] Allocation mode set to FORCED (Physical allocator)\n";
 }
 
+vector<Relocation> IntegratedMemorySystem::compactHeap(Size max_bytes)
+{
+    vector<Relocation> relocations;
+    if (!initialized_)
+        return relocations;
+
+    physical_allocator_->compactStep(max_bytes > 0 ? max_bytes : total_memory_, relocations);
+    applyRelocations(relocations);
+    return relocations;
+}
+
+void IntegratedMemorySystem::setAutoCompaction(double threshold, Size step_bytes)
+{
+    compaction_threshold_ = threshold;
+    compaction_step_bytes_ = step_bytes;
+}
+
+Address IntegratedMemorySystem::resolveRelocation(Address address) const
+{
+    auto it = relocated_to_.find(address);
+    return it != relocated_to_.end() ? it->second : address;
+}
+
+void IntegratedMemorySystem::applyRelocations(const vector<Relocation> &relocations)
+{
+    vector<pair<Address, Address>> moved_objects;
+    for (const auto &r : relocations)
+    {
+        auto pit = process_allocations_.find(r.process_id);
+        if (pit == process_allocations_.end())
+            continue;
+
+        auto &allocs = pit->second;
+        if (allocs.physical.erase(r.old_address))
+        {
+            allocs.physical.insert(r.new_address);
+            recordMove(r.old_address, r.new_address);
+            continue;
+        }
+
+        // Arena chunks carry every object inside them along.
+        moved_objects.clear();
+        if (allocs.arena.relocateChunk(r.old_address, r.new_address, moved_objects))
+        {
+            for (const auto &m : moved_objects)
+                recordMove(m.first, m.second);
+        }
+    }
+}
+
+void IntegratedMemorySystem::recordMove(Address old_address, Address new_address)
+{
+    vector<Address> earlier;
+    auto from = relocated_from_.find(old_address);
+    if (from != relocated_from_.end())
+    {
+        earlier = move(from->second);
+        relocated_from_.erase(from);
+    }
+    earlier.push_back(old_address);
+
+    for (Address address : earlier)
+        relocated_to_[address] = new_address;
+
+    // The new address may have been vacated earlier; it is live again now.
+    relocated_to_.erase(new_address);
+    relocated_from_[new_address] = move(earlier);
+}
+
+void IntegratedMemorySystem::forgetRelocations(Address address)
+{
+    // A new block at a vacated address: the old forward is stale.
+    auto to = relocated_to_.find(address);
+    if (to != relocated_to_.end())
+    {
+        auto from = relocated_from_.find(to->second);
+        if (from != relocated_from_.end())
+        {
+            auto &earlier = from->second;
+            earlier.erase(remove(earlier.begin(), earlier.end(), address), earlier.end());
+            if (earlier.empty())
+                relocated_from_.erase(from);
+        }
+        relocated_to_.erase(to);
+    }
+
+    // A moved object freed: nothing should forward to it any more.
+    auto from = relocated_from_.find(address);
+    if (from != relocated_from_.end())
+    {
+        for (Address earlier : from->second)
+            relocated_to_.erase(earlier);
+        relocated_from_.erase(from);
+    }
+}
+
+void IntegratedMemorySystem::maybeCompact()
+{
+    if (compaction_threshold_ <= 0.0)
+        return;
+
+    // A bounded step per operation keeps each pause short; fragmentation
+    // is worked off over the following allocations and frees.
+    if (physical_allocator_->getStats().fragmentation_ratio > compaction_threshold_)
+        compactHeap(compaction_step_bytes_);
+}
+
+size_t IntegratedMemorySystem::drainPageCaches()
+{
+    size_t drained = 0;
+    for (auto &p : process_allocations_)
+        drained += p.second.pages.drain(*buddy_allocator_);
+    return drained;
+}
+
+void IntegratedMemorySystem::retirePageCache(const PageCache &pages)
+{
+    // Only the counters carry over; the pages are freed or orphaned.
+    auto stats = pages.getStats();
+    stats.cached_pages = 0;
+    stats.pages_in_use = 0;
+    retired_page_cache_stats_ += stats;
+}
+
+void IntegratedMemorySystem::setPageCacheWatermarks(size_t low, size_t high)
+{
+    page_cache_low_ = min(low, high);
+    page_cache_high_ = high;
+    for (auto &p : process_allocations_)
+        p.second.pages.setWatermarks(*buddy_allocator_, low, high);
+}
+
+PageCache::Stats IntegratedMemorySystem::getPageCacheStats() const
+{
+    PageCache::Stats total = retired_page_cache_stats_;
+    for (const auto &p : process_allocations_)
+        total += p.second.pages.getStats();
+    return total;
+}
+
+void IntegratedMemorySystem::setMetadataTracing(bool enabled)
+{
+    metadata_tracing_ = enabled;
+    if (enabled)
+    {
+        metadata_accesses_ = 0;
+        metadata_misses_ = 0;
+        metadata_allocations_ = 0;
+    }
+    attachMetadataObservers();
+}
+
+void IntegratedMemorySystem::attachMetadataObservers()
+{
+    if (!physical_allocator_ || !buddy_allocator_)
+        return;
+
+    if (!metadata_tracing_)
+    {
+        physical_allocator_->setMetadataObserver(nullptr);
+        buddy_allocator_->setMetadataObserver(nullptr);
+        return;
+    }
+
+    // Metadata is in physical memory and belongs to no process, so it
+    // skips address translation and goes straight to the caches. The buddy
+    // region is placed above the physical heap and its metadata.
+    auto observer = [this](Address base)
+    {
+        return [this, base](Address address, bool is_write)
+        {
+            metadata_accesses_++;
+            bool hit = is_write ? cache_hierarchy_->write(base + address, -1)
+                                : cache_hierarchy_->read(base + address, -1);
+            if (!hit)
+                metadata_misses_++;
+        };
+    };
+    physical_allocator_->setMetadataObserver(observer(0));
+    buddy_allocator_->setMetadataObserver(observer(static_cast<Address>(4 * uint64_t(total_memory_))));
+}
+
 bool IntegratedMemorySystem::hasProcess(ProcessId pid) const
 {
     return process_allocations_.find(pid) != process_allocations_.end();
@@ -239,6 +802,9 @@ void IntegratedMemorySystem::switchPageReplacementPolicy(PageReplacementPolicy n
         page_size_,
         new_policy);
 
+    drainPageCaches();
+    for (const auto &p : process_allocations_)
+        retirePageCache(p.second.pages);
     auto old = process_allocations_;
     process_allocations_.clear();
 
@@ -420,6 +986,14 @@ void IntegratedMemorySystem::printProcessInfo(ProcessId process_id) const
     if (it == process_allocations_.end())
         return;
     cout << "Process " << process_id << " allocations: " << it->second.size() << endl;
+
+    const auto &arena = it->second.arena;
+    if (arena.chunkCount() > 0)
+    {
+        cout << "Arena: " << arena.objectCount() << " objects in "
+             << arena.chunkCount() << " chunks ("
+             << formatSize(arena.reservedBytes()) << " reserved)" << endl;
+    }
 }
 
 void IntegratedMemorySystem::runMemoryTest(const string &test_name)
@@ -445,7 +1019,12 @@ void IntegratedMemorySystem::benchmarkAllocationStrategies()
     vector<AllocationStrategy> strategies = {
         AllocationStrategy::FIRST_FIT,
         AllocationStrategy::BEST_FIT,
-        AllocationStrategy::WORST_FIT};
+        AllocationStrategy::WORST_FIT,
+        AllocationStrategy::NEXT_FIT,
+        AllocationStrategy::TLSF,
+        AllocationStrategy::BITMAP,
+        AllocationStrategy::PTMALLOC,
+        AllocationStrategy::LIFETIME};
 
     for (auto s : strategies)
     {
@@ -462,6 +1041,889 @@ void IntegratedMemorySystem::benchmarkAllocationStrategies()
     }
 }
 
+void IntegratedMemorySystem::benchmarkAllocationScaling(size_t max_live_blocks)
+{
+    constexpr size_t MEASURED_ALLOCATIONS = 2000;
+    constexpr Size BLOCK_SIZES[] = {16, 48, 32, 80, 24, 64, 112};
+
+    const vector<pair<AllocationStrategy, string>> strategies = {
+        {AllocationStrategy::FIRST_FIT, "first"},
+        {AllocationStrategy::BEST_FIT, "best"},
+        {AllocationStrategy::WORST_FIT, "worst"},
+        {AllocationStrategy::NEXT_FIT, "next"},
+        {AllocationStrategy::TLSF, "tlsf"}};
+
+    cout << left
+         << setw(10) << "Strategy"
+         << setw(14) << "Live blocks"
+         << setw(14) << "Free holes"
+         << setw(14) << "Allocs/sec"
+         << "Avg scan\n";
+
+    for (const auto &s : strategies)
+    {
+        for (size_t live = 1000; live <= max_live_blocks; live *= 2)
+        {
+            // Private allocator so the benchmark never disturbs the running system.
+            Size memory = static_cast<Size>(live * 128 + MEASURED_ALLOCATIONS * 128);
+            auto allocator = createAllocator(s.first, memory);
+            allocator->initialize(memory);
+
+            vector<BlockId> ids;
+            ids.reserve(live);
+            for (size_t i = 0; i < live; ++i)
+            {
+                auto r = allocator->allocate({BLOCK_SIZES[i % 7], 1});
+                if (r.success)
+                    ids.push_back(r.block_id);
+            }
+
+            // Free every other block so the heap is a comb of small holes.
+            for (size_t i = 1; i < ids.size(); i += 2)
+            {
+                allocator->deallocate(ids[i]);
+            }
+
+            const auto &blocks = allocator->getBlocks();
+            size_t holes = count_if(blocks.begin(), blocks.end(),
+                                    [](const MemoryBlock &b) { return b.isFree(); });
+
+            size_t scanned_before = allocator->getStats().blocks_scanned;
+            auto start = chrono::steady_clock::now();
+            for (size_t i = 0; i < MEASURED_ALLOCATIONS; ++i)
+            {
+                allocator->allocate({BLOCK_SIZES[(i * 3) % 7], 2});
+            }
+            auto elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            size_t scanned = allocator->getStats().blocks_scanned - scanned_before;
+
+            cout << setw(10) << s.second
+                 << setw(14) << live
+                 << setw(14) << holes
+                 << fixed << setprecision(0)
+                 << setw(14) << MEASURED_ALLOCATIONS / max(elapsed, 1e-9)
+                 << setprecision(1)
+                 << static_cast<double>(scanned) / MEASURED_ALLOCATIONS << "\n";
+            cout.unsetf(ios::fixed);
+            cout << setprecision(6);
+        }
+    }
+}
+
+void IntegratedMemorySystem::benchmarkFitScan(size_t max_live_blocks)
+{
+    constexpr size_t MEASURED_ALLOCATIONS = 200;
+
+    const vector<pair<AllocationStrategy, string>> strategies = {
+        {AllocationStrategy::FIRST_FIT, "first"},
+        {AllocationStrategy::NEXT_FIT, "next"}};
+
+    cout << left
+         << setw(10) << "Strategy"
+         << setw(14) << "Live blocks"
+         << setw(14) << "Allocs/sec"
+         << "Avg scan\n";
+
+    for (const auto &s : strategies)
+    {
+        for (size_t live = 1000; live <= max_live_blocks; live *= 4)
+        {
+            Size memory = static_cast<Size>(live * 64 + 4096);
+            auto allocator = createAllocator(s.first, memory);
+            allocator->initialize(memory);
+
+            vector<Address> addresses;
+            addresses.reserve(live);
+            for (size_t i = 0; i < live; ++i)
+            {
+                auto r = allocator->allocate({64, 1});
+                if (r.success)
+                    addresses.push_back(r.address);
+            }
+            for (size_t i = 1; i < addresses.size(); i += 2)
+            {
+                allocator->deallocateAddress(addresses[i], 1);
+            }
+
+            // Every 64-byte hole is too small, so each search has to pass
+            // all of them to reach the free tail; freeing the block again
+            // leaves the next-fit rover past the last block, so the next
+            // search wraps and starts from the bottom.
+            size_t scanned_before = allocator->getStats().blocks_scanned;
+            auto start = chrono::steady_clock::now();
+            for (size_t i = 0; i < MEASURED_ALLOCATIONS; ++i)
+            {
+                auto r = allocator->allocate({2048, 2});
+                if (r.success)
+                    allocator->deallocateAddress(r.address, 2);
+            }
+            auto elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            size_t scanned = allocator->getStats().blocks_scanned - scanned_before;
+
+            cout << setw(10) << s.second
+                 << setw(14) << live
+                 << fixed << setprecision(0)
+                 << setw(14) << MEASURED_ALLOCATIONS / max(elapsed, 1e-9)
+                 << setprecision(1)
+                 << static_cast<double>(scanned) / MEASURED_ALLOCATIONS << "\n";
+            cout.unsetf(ios::fixed);
+            cout << setprecision(6);
+        }
+    }
+}
+
+void IntegratedMemorySystem::benchmarkAllocationLatency(size_t operations)
+{
+    constexpr Size MEMORY = 16 * 1024 * 1024;
+
+    const vector<pair<AllocationStrategy, string>> strategies = {
+        {AllocationStrategy::FIRST_FIT, "first"},
+        {AllocationStrategy::BEST_FIT, "best"},
+        {AllocationStrategy::WORST_FIT, "worst"},
+        {AllocationStrategy::NEXT_FIT, "next"},
+        {AllocationStrategy::TLSF, "tlsf"}};
+
+    cout << left
+         << setw(10) << "Strategy"
+         << setw(12) << "Avg (ns)"
+         << setw(12) << "p99 (ns)"
+         << setw(12) << "Max (ns)"
+         << "Failures\n";
+
+    for (const auto &s : strategies)
+    {
+        auto allocator = createAllocator(s.first, MEMORY);
+        allocator->initialize(MEMORY);
+
+        // Same pseudo-random alloc/free trace for every strategy.
+        uint32_t seed = 12345;
+        auto next_random = [&seed]()
+        {
+            seed = seed * 1103515245u + 12345u;
+            return seed >> 8;
+        };
+
+        vector<BlockId> live;
+        vector<double> latencies;
+        latencies.reserve(operations);
+        size_t failures = 0;
+
+        for (size_t i = 0; i < operations; ++i)
+        {
+            bool do_alloc = live.empty() || next_random() % 100 < 55;
+            Size size = 16 + next_random() % 2048;
+            size_t victim = live.empty() ? 0 : next_random() % live.size();
+
+            auto start = chrono::steady_clock::now();
+            if (do_alloc)
+            {
+                auto r = allocator->allocate({size, 1});
+                if (r.success)
+                    live.push_back(r.block_id);
+                else
+                    failures++;
+            }
+            else
+            {
+                allocator->deallocate(live[victim]);
+                live[victim] = live.back();
+                live.pop_back();
+            }
+            auto end = chrono::steady_clock::now();
+
+            latencies.push_back(chrono::duration<double, nano>(end - start).count());
+        }
+
+        double total = 0.0;
+        for (double ns : latencies)
+            total += ns;
+        sort(latencies.begin(), latencies.end());
+
+        cout << setw(10) << s.second
+             << fixed << setprecision(0)
+             << setw(12) << total / latencies.size()
+             << setw(12) << latencies[latencies.size() * 99 / 100]
+             << setw(12) << latencies.back()
+             << failures << "\n";
+        cout.unsetf(ios::fixed);
+        cout << setprecision(6);
+    }
+}
+
+void IntegratedMemorySystem::benchmarkSmallObjects(size_t operations)
+{
+    constexpr Size MEMORY = 16 * 1024 * 1024;
+
+    const vector<pair<AllocationStrategy, string>> strategies = {
+        {AllocationStrategy::FIRST_FIT, "first"},
+        {AllocationStrategy::BEST_FIT, "best"},
+        {AllocationStrategy::TLSF, "tlsf"},
+        {AllocationStrategy::BITMAP, "bitmap"},
+        {AllocationStrategy::PTMALLOC, "ptmalloc"}};
+
+    cout << left
+         << setw(10) << "Strategy"
+         << setw(14) << "Ops/sec"
+         << setw(14) << "Live blocks"
+         << "Metadata\n";
+
+    for (const auto &s : strategies)
+    {
+        auto allocator = createAllocator(s.first, MEMORY);
+        allocator->initialize(MEMORY);
+
+        // Objects of 8-128 bytes; the live set grows slowly over the run.
+        uint32_t seed = 777;
+        auto next_random = [&seed]()
+        {
+            seed = seed * 1103515245u + 12345u;
+            return seed >> 8;
+        };
+
+        vector<BlockId> live;
+        auto start = chrono::steady_clock::now();
+        for (size_t i = 0; i < operations; ++i)
+        {
+            if (live.empty() || next_random() % 100 < 60)
+            {
+                auto r = allocator->allocate({8 + next_random() % 121, 1});
+                if (r.success)
+                    live.push_back(r.block_id);
+            }
+            else
+            {
+                size_t victim = next_random() % live.size();
+                allocator->deallocate(live[victim]);
+                live[victim] = live.back();
+                live.pop_back();
+            }
+        }
+        auto elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        cout << setw(10) << s.second
+             << fixed << setprecision(0)
+             << setw(14) << operations / max(elapsed, 1e-9)
+             << setw(14) << live.size()
+             << formatSize(static_cast<Size>(allocator->getMetadataBytes())) << "\n";
+        cout.unsetf(ios::fixed);
+        cout << setprecision(6);
+    }
+}
+
+void IntegratedMemorySystem::benchmarkProcessTeardown(size_t max_objects)
+{
+    constexpr Size OBJECT_SIZES[] = {24, 160, 48, 96, 16, 256, 72};
+
+    cout << left
+         << setw(10) << "Objects"
+         << setw(16) << "Per-object (us)"
+         << setw(12) << "Arena (us)"
+         << setw(10) << "Chunks"
+         << "Speedup\n";
+
+    for (size_t objects = 2000; objects <= max_objects; objects *= 2)
+    {
+        Size memory = static_cast<Size>(objects * 256 + 1024 * 1024);
+
+        // Current path: every object is its own block and is freed on its own,
+        // in hash-set order like terminateProcess.
+        auto allocator = createAllocator(alloc_strategy_, memory);
+        allocator->initialize(memory);
+        unordered_set<Address> addresses;
+        for (size_t i = 0; i < objects; ++i)
+        {
+            auto r = allocator->allocate({OBJECT_SIZES[i % 7], 1});
+            if (r.success)
+                addresses.insert(r.address);
+        }
+
+        auto start = chrono::steady_clock::now();
+        for (Address addr : addresses)
+        {
+            allocator->deallocateAddress(addr, 1);
+        }
+        double per_object = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+
+        // Arena path: the same objects carved from chunks, released in one pass.
+        auto arena_allocator = createAllocator(alloc_strategy_, memory);
+        arena_allocator->initialize(memory);
+        ProcessArena arena;
+        for (size_t i = 0; i < objects; ++i)
+        {
+            arena.allocate(*arena_allocator, {OBJECT_SIZES[i % 7], 1});
+        }
+        size_t chunks = arena.chunkCount();
+
+        start = chrono::steady_clock::now();
+        arena.releaseAll(*arena_allocator, 1);
+        double bulk = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+
+        cout << setw(10) << objects
+             << fixed << setprecision(1)
+             << setw(16) << per_object
+             << setw(12) << bulk
+             << setw(10) << chunks
+             << per_object / max(bulk, 1e-3) << "x\n";
+        cout.unsetf(ios::fixed);
+        cout << setprecision(6);
+    }
+}
+
+void IntegratedMemorySystem::benchmarkConcurrentScaling(size_t max_threads, bool buddy_backend)
+{
+    constexpr size_t OPS_PER_THREAD = 100000;
+    constexpr size_t MAX_LIVE = 1024;
+    constexpr Size MEMORY = 64 * 1024 * 1024;
+
+    if (max_threads == 0)
+        max_threads = max<size_t>(1, thread::hardware_concurrency());
+
+    vector<size_t> thread_counts;
+    for (size_t threads = 1; threads < max_threads; threads *= 2)
+        thread_counts.push_back(threads);
+    thread_counts.push_back(max_threads);
+
+    // Each thread plays one simulated process running the same churn.
+    auto churn = [](size_t thread_index, auto &&alloc, auto &&release)
+    {
+        uint32_t seed = 4242 + static_cast<uint32_t>(thread_index);
+        auto next_random = [&seed]()
+        {
+            seed = seed * 1103515245u + 12345u;
+            return seed >> 8;
+        };
+
+        vector<pair<Address, Size>> live;
+        live.reserve(MAX_LIVE);
+        for (size_t i = 0; i < OPS_PER_THREAD; ++i)
+        {
+            if (live.empty() || (live.size() < MAX_LIVE && next_random() % 2 == 0))
+            {
+                Size size = 16 + next_random() % 497;
+                auto r = alloc(size);
+                if (r.success)
+                    live.emplace_back(r.address, size);
+            }
+            else
+            {
+                size_t victim = next_random() % live.size();
+                release(live[victim].first, live[victim].second);
+                live[victim] = live.back();
+                live.pop_back();
+            }
+        }
+        for (const auto &obj : live)
+            release(obj.first, obj.second);
+    };
+
+    auto run = [](size_t threads, auto &&body)
+    {
+        vector<thread> workers;
+        auto start = chrono::steady_clock::now();
+        for (size_t t = 0; t < threads; ++t)
+            workers.emplace_back(body, t);
+        for (auto &w : workers)
+            w.join();
+        double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        return threads * OPS_PER_THREAD / max(elapsed, 1e-9);
+    };
+
+    cout << left
+         << setw(10) << "Threads"
+         << setw(16) << "Locked ops/s"
+         << setw(16) << "Cached ops/s"
+         << setw(10) << "Speedup"
+         << setw(10) << "Locks/op"
+         << "Spans freed\n";
+
+    for (size_t threads : thread_counts)
+    {
+        unique_ptr<BaseAllocator> physical[2];
+        unique_ptr<BuddyAllocator> buddy[2];
+        auto make_backend = [&](size_t i)
+        {
+            if (buddy_backend)
+            {
+                buddy[i] = make_unique<BuddyAllocator>(MEMORY);
+                buddy[i]->initialize();
+                return ThreadCachingAllocator::backendFor(*buddy[i]);
+            }
+            physical[i] = createAllocator(alloc_strategy_, MEMORY);
+            physical[i]->initialize(MEMORY);
+            return ThreadCachingAllocator::backendFor(*physical[i]);
+        };
+
+        // Baseline: one lock around the back end for every request.
+        auto locked_backend = make_backend(0);
+        mutex backend_lock;
+
+        auto locked_worker = [&](size_t t)
+        {
+            ProcessId pid = static_cast<ProcessId>(t + 1);
+            auto alloc = [&](Size size)
+            {
+                lock_guard<mutex> guard(backend_lock);
+                return locked_backend.allocate({size, pid});
+            };
+            auto release = [&](Address address, Size)
+            {
+                lock_guard<mutex> guard(backend_lock);
+                locked_backend.deallocate(address, pid);
+            };
+            churn(t, alloc, release);
+        };
+
+        ThreadCachingAllocator front_end(make_backend(1));
+
+        auto cached_worker = [&](size_t t)
+        {
+            ThreadCachingAllocator::ThreadCache cache(front_end, static_cast<ProcessId>(t + 1));
+            auto alloc = [&](Size size) { return cache.allocate(size); };
+            auto release = [&](Address address, Size size) { cache.deallocate(address, size); };
+            churn(t, alloc, release);
+        };
+
+        double locked = run(threads, locked_worker);
+        double cached = run(threads, cached_worker);
+        auto stats = front_end.getStats();
+        double locks_per_op = static_cast<double>(stats.lock_acquisitions) /
+                              (threads * OPS_PER_THREAD);
+
+        cout << setw(10) << threads
+             << fixed << setprecision(0)
+             << setw(16) << locked
+             << setw(16) << cached
+             << setprecision(1)
+             << setw(10) << cached / max(locked, 1e-9)
+             << setprecision(4)
+             << setw(10) << locks_per_op
+             << stats.spans_released << " / " << stats.spans_carved << "\n";
+        cout.unsetf(ios::fixed);
+        cout << setprecision(6);
+    }
+}
+
+void IntegratedMemorySystem::benchmarkBatchReplay(size_t phases, size_t batch_size)
+{
+    constexpr Size MEMORY = 16 * 1024 * 1024;
+
+    const vector<pair<AllocationStrategy, string>> strategies = {
+        {AllocationStrategy::FIRST_FIT, "first"},
+        {AllocationStrategy::BEST_FIT, "best"},
+        {AllocationStrategy::NEXT_FIT, "next"},
+        {AllocationStrategy::TLSF, "tlsf"},
+        {AllocationStrategy::BITMAP, "bitmap"},
+        {AllocationStrategy::PTMALLOC, "ptmalloc"}};
+
+    // A trace of phases: each one mallocs a burst of small objects, then
+    // frees them all, as a replayed request handler would.
+    vector<Size> sizes(batch_size);
+    uint32_t seed = 99;
+    for (auto &size : sizes)
+    {
+        seed = seed * 1103515245u + 12345u;
+        size = 16 + (seed >> 8) % 241;
+    }
+
+    cout << left
+         << setw(10) << "Strategy"
+         << setw(16) << "Per-call ops/s"
+         << setw(16) << "Batch ops/s"
+         << "Speedup\n";
+
+    for (const auto &s : strategies)
+    {
+        auto single = createAllocator(s.first, MEMORY);
+        single->initialize(MEMORY);
+        vector<Address> addresses;
+        addresses.reserve(batch_size);
+
+        auto start = chrono::steady_clock::now();
+        for (size_t phase = 0; phase < phases; ++phase)
+        {
+            addresses.clear();
+            for (Size size : sizes)
+            {
+                auto r = single->allocate({size, 1});
+                if (r.success)
+                    addresses.push_back(r.address);
+            }
+            for (Address address : addresses)
+            {
+                single->deallocateAddress(address, 1);
+            }
+        }
+        double per_call = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        auto batched = createAllocator(s.first, MEMORY);
+        batched->initialize(MEMORY);
+
+        start = chrono::steady_clock::now();
+        for (size_t phase = 0; phase < phases; ++phase)
+        {
+            addresses.clear();
+            for (const auto &r : batched->allocateBatch(sizes, 1))
+            {
+                if (r.success)
+                    addresses.push_back(r.address);
+            }
+            batched->deallocateBatch(addresses, 1);
+        }
+        double batch = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        double ops = 2.0 * phases * batch_size;
+        cout << setw(10) << s.second
+             << fixed << setprecision(0)
+             << setw(16) << ops / max(per_call, 1e-9)
+             << setw(16) << ops / max(batch, 1e-9)
+             << setprecision(2)
+             << per_call / max(batch, 1e-9) << "x\n";
+        cout.unsetf(ios::fixed);
+        cout << setprecision(6);
+    }
+}
+
+void IntegratedMemorySystem::benchmarkAlignment(size_t objects)
+{
+    constexpr Size MEMORY = 4 * 1024 * 1024;
+    constexpr Size LINE = 64;
+    constexpr Size RECORD = 64;
+    constexpr int PASSES = 4;
+
+    cout << left
+         << setw(11) << "Alignment"
+         << setw(12) << "Lines/obj"
+         << setw(12) << "L1 hit %"
+         << setw(14) << "AMAT (cyc)"
+         << setw(12) << "Padding"
+         << "Ext. frag\n";
+
+    for (Size alignment : {Size(0), LINE})
+    {
+        auto allocator = createAllocator(AllocationStrategy::FIRST_FIT, MEMORY);
+        allocator->initialize(MEMORY);
+        CacheHierarchy caches(32768, 262144, 2097152,
+                              LINE, 8, 16, 16,
+                              CacheReplacementPolicy::LRU,
+                              CacheReplacementPolicy::LRU,
+                              CacheReplacementPolicy::LRU);
+
+        // Line-sized records interleaved with small headers, so unaligned
+        // records straddle two cache lines.
+        vector<Address> records;
+        vector<Address> headers;
+        for (size_t i = 0; i < objects; ++i)
+        {
+            auto header = allocator->allocate({24, 1});
+            auto record = allocator->allocate({RECORD, 1, alignment});
+            if (!header.success || !record.success)
+                break;
+            headers.push_back(header.address);
+            records.push_back(record.address);
+        }
+
+        size_t lines = 0;
+        for (Address a : records)
+            lines += (a + RECORD - 1) / LINE - a / LINE + 1;
+
+        // Walk every record word by word a few times; the working set is
+        // larger than L1, so each extra line touched costs a miss.
+        for (int pass = 0; pass < PASSES; ++pass)
+        {
+            for (Address a : records)
+            {
+                for (Size offset = 0; offset < RECORD; offset += 8)
+                    caches.read(a + offset, 1);
+            }
+        }
+
+        // Headers die first, leaving the padding holes behind.
+        allocator->deallocateBatch(headers, 1);
+
+        auto cache_stats = caches.getStats();
+        auto alloc_stats = allocator->getStats();
+        size_t l1_accesses = cache_stats.l1_stats.hits + cache_stats.l1_stats.misses;
+
+        cout << setw(11) << (alignment ? to_string(alignment) + " B" : string("none"))
+             << fixed << setprecision(2)
+             << setw(12) << (records.empty() ? 0.0 : static_cast<double>(lines) / records.size())
+             << setw(12) << (l1_accesses ? 100.0 * cache_stats.l1_stats.hits / l1_accesses : 0.0)
+             << setw(14) << cache_stats.avg_memory_access_time
+             << setw(12) << formatSize(alloc_stats.alignment_waste)
+             << alloc_stats.fragmentation_ratio * 100 << " %\n";
+        cout.unsetf(ios::fixed);
+        cout << setprecision(6);
+    }
+}
+
+void IntegratedMemorySystem::benchmarkLifetimePlacement(size_t operations)
+{
+    constexpr Size MEMORY = 4 * 1024 * 1024;
+    constexpr size_t SAMPLES = 10;
+    constexpr uint32_t MAX_SHORT_DELAY = 200;
+
+    // Allocation sites with a fixed size and lifetime each, as in a server
+    // that keeps sessions alive while churning request buffers. A few
+    // long-lived objects are freed too, so holes appear in both layouts.
+    struct Site
+    {
+        Size size;
+        bool long_lived;
+        uint32_t weight;
+    };
+    const vector<Site> sites = {
+        {48, true, 3}, {200, true, 2}, {640, true, 1},
+        {32, false, 30}, {96, false, 25}, {256, false, 20}, {1500, false, 10}, {4000, false, 9}};
+    uint32_t total_weight = 0;
+    for (const auto &site : sites)
+        total_weight += site.weight;
+
+    struct Config
+    {
+        string name;
+        AllocationStrategy strategy;
+        bool hints;
+    };
+    const vector<Config> configs = {
+        {"first", AllocationStrategy::FIRST_FIT, false},
+        {"hinted", AllocationStrategy::LIFETIME, true},
+        {"predicted", AllocationStrategy::LIFETIME, false}};
+
+    // Fragmentation samples per config, then one row per sample.
+    vector<vector<double>> samples(configs.size());
+    vector<size_t> failures(configs.size(), 0);
+    LifetimeAllocator::LifetimeStats predictor{};
+
+    for (size_t c = 0; c < configs.size(); ++c)
+    {
+        auto allocator = createAllocator(configs[c].strategy, MEMORY);
+        allocator->initialize(MEMORY);
+
+        uint32_t seed = 4242;
+        auto next_random = [&seed]()
+        {
+            seed = seed * 1103515245u + 12345u;
+            return seed >> 8;
+        };
+
+        vector<Address> long_lived;
+        multimap<size_t, Address> short_lived;   // due op -> address
+        for (size_t op = 1; op <= operations; ++op)
+        {
+            while (!short_lived.empty() && short_lived.begin()->first <= op)
+            {
+                allocator->deallocateAddress(short_lived.begin()->second, 1);
+                short_lived.erase(short_lived.begin());
+            }
+
+            if (!long_lived.empty() && next_random() % 100 < 2)
+            {
+                size_t victim = next_random() % long_lived.size();
+                allocator->deallocateAddress(long_lived[victim], 1);
+                long_lived[victim] = long_lived.back();
+                long_lived.pop_back();
+            }
+
+            uint32_t pick = next_random() % total_weight;
+            size_t s = 0;
+            while (pick >= sites[s].weight)
+                pick -= sites[s++].weight;
+            const Site &site = sites[s];
+
+            LifetimeHint hint = LifetimeHint::UNKNOWN;
+            if (configs[c].hints)
+                hint = site.long_lived ? LifetimeHint::LONG : LifetimeHint::SHORT;
+            uint32_t delay = 1 + next_random() % MAX_SHORT_DELAY;
+
+            auto r = allocator->allocate({site.size, 1, 0, hint});
+            if (!r.success)
+                failures[c]++;
+            else if (site.long_lived)
+                long_lived.push_back(r.address);
+            else
+                short_lived.emplace(op + delay, r.address);
+
+            if (op % (operations / SAMPLES) == 0)
+                samples[c].push_back(allocator->getStats().fragmentation_ratio * 100);
+        }
+
+        if (!configs[c].hints && configs[c].strategy == AllocationStrategy::LIFETIME)
+            predictor = static_cast<LifetimeAllocator &>(*allocator).getLifetimeStats();
+    }
+
+    cout << left << setw(10) << "Ops";
+    for (const auto &config : configs)
+        cout << setw(14) << config.name;
+    cout << "(external fragmentation %)\n";
+
+    cout << fixed << setprecision(2);
+    for (size_t i = 0; i < SAMPLES; ++i)
+    {
+        cout << setw(10) << (i + 1) * (operations / SAMPLES);
+        for (const auto &column : samples)
+            cout << setw(14) << (i < column.size() ? column[i] : 0.0);
+        cout << "\n";
+    }
+
+    cout << setw(10) << "Failures";
+    for (size_t f : failures)
+        cout << setw(14) << f;
+    cout << "\nPredictor accuracy: "
+         << (predictor.predictions_checked
+                 ? 100.0 * predictor.predictions_correct / predictor.predictions_checked
+                 : 0.0)
+         << " % of " << predictor.predictions_checked << " objects\n";
+    cout.unsetf(ios::fixed);
+    cout << setprecision(6);
+}
+
+void IntegratedMemorySystem::benchmarkMetadataTraffic(size_t operations)
+{
+    constexpr Size MEMORY = 16 * 1024 * 1024;
+
+    const vector<pair<AllocationStrategy, string>> strategies = {
+        {AllocationStrategy::FIRST_FIT, "first"},
+        {AllocationStrategy::BEST_FIT, "best"},
+        {AllocationStrategy::WORST_FIT, "worst"},
+        {AllocationStrategy::NEXT_FIT, "next"},
+        {AllocationStrategy::TLSF, "tlsf"},
+        {AllocationStrategy::BITMAP, "bitmap"},
+        {AllocationStrategy::PTMALLOC, "ptmalloc"},
+        {AllocationStrategy::LIFETIME, "lifetime"}};
+
+    // One trace for every allocator: mostly small objects with a tail of
+    // larger ones, a live set that grows to a few thousand blocks, and
+    // frees in random order.
+    struct Op
+    {
+        bool alloc;
+        Size size;
+        size_t victim;
+    };
+    vector<Op> trace;
+    trace.reserve(operations);
+    uint32_t seed = 4242;
+    auto next_random = [&seed]()
+    {
+        seed = seed * 1103515245u + 12345u;
+        return seed >> 8;
+    };
+    size_t live = 0;
+    size_t allocations = 0;
+    for (size_t i = 0; i < operations; ++i)
+    {
+        if (live == 0 || next_random() % 100 < 55)
+        {
+            Size size = next_random() % 8 == 0 ? 512 + next_random() % 7681 : 16 + next_random() % 241;
+            trace.push_back({true, size, 0});
+            live++;
+            allocations++;
+        }
+        else
+        {
+            trace.push_back({false, 0, next_random() % live});
+            live--;
+        }
+    }
+
+    const Address FAILED = static_cast<Address>(-1);
+    auto freshCaches = []()
+    {
+        return make_unique<CacheHierarchy>(
+            32768, 262144, 2097152,
+            64, 8, 16, 16,
+            CacheReplacementPolicy::LRU,
+            CacheReplacementPolicy::LRU,
+            CacheReplacementPolicy::LRU);
+    };
+
+    cout << left
+         << setw(10) << "Strategy"
+         << setw(14) << "Accesses/op"
+         << setw(14) << "L1 miss/op"
+         << setw(14) << "Memory/op"
+         << "AMAT\n";
+
+    auto report = [&](const string &name, size_t accesses, const CacheHierarchy &caches)
+    {
+        auto stats = caches.getStats();
+        double ops = static_cast<double>(max<size_t>(allocations, 1));
+        cout << setw(10) << name
+             << fixed << setprecision(2)
+             << setw(14) << accesses / ops
+             << setw(14) << stats.l1_stats.misses / ops
+             << setw(14) << stats.main_memory_accesses / ops
+             << stats.avg_memory_access_time << "\n";
+        cout.unsetf(ios::fixed);
+        cout << setprecision(6);
+    };
+
+    for (const auto &s : strategies)
+    {
+        auto allocator = createAllocator(s.first, MEMORY);
+        allocator->initialize(MEMORY);
+        auto caches = freshCaches();
+        size_t accesses = 0;
+        allocator->setMetadataObserver([&](Address address, bool is_write)
+                                       {
+                                           accesses++;
+                                           if (is_write)
+                                               caches->write(address, -1);
+                                           else
+                                               caches->read(address, -1);
+                                       });
+
+        vector<Address> addresses;
+        for (const auto &op : trace)
+        {
+            if (op.alloc)
+            {
+                auto r = allocator->allocate({op.size, 1});
+                addresses.push_back(r.success ? r.address : FAILED);
+                continue;
+            }
+            Address address = addresses[op.victim];
+            addresses[op.victim] = addresses.back();
+            addresses.pop_back();
+            if (address != FAILED)
+                allocator->deallocateAddress(address, 1);
+        }
+        report(s.second, accesses, *caches);
+    }
+
+    BuddyAllocator buddy(MEMORY);
+    buddy.initialize();
+    auto caches = freshCaches();
+    size_t accesses = 0;
+    buddy.setMetadataObserver([&](Address address, bool is_write)
+                              {
+                                  accesses++;
+                                  if (is_write)
+                                      caches->write(address, -1);
+                                  else
+                                      caches->read(address, -1);
+                              });
+    vector<Address> addresses;
+    for (const auto &op : trace)
+    {
+        if (op.alloc)
+        {
+            auto r = buddy.allocate({op.size, 1});
+            addresses.push_back(r.success ? r.address : FAILED);
+            continue;
+        }
+        Address address = addresses[op.victim];
+        addresses[op.victim] = addresses.back();
+        addresses.pop_back();
+        if (address != FAILED)
+            buddy.deallocate(address);
+    }
+    report("buddy", accesses, *caches);
+
+    cout << "Per allocation, counting its share of the frees. Only allocator\n"
+         << "metadata is accessed; object contents are not.\n";
+}
+
 void IntegratedMemorySystem::benchmarkCachePerformance()
 {
     ProcessId pid = 1001;
@@ -482,14 +1944,81 @@ MemoryStats IntegratedMemorySystem::getPhysicalAllocatorStats() const
 {
     if (!physical_allocator_)
         return MemoryStats();
-    return physical_allocator_->getStats();
+    MemoryStats stats = physical_allocator_->getStats();
+    // Arena chunks are physical blocks.
+    stats.realloc_moved += arena_realloc_moves_.moved;
+    stats.realloc_bytes_copied += arena_realloc_moves_.bytes_copied;
+    return stats;
+}
+
+PtmallocAllocator::BinStats IntegratedMemorySystem::getPtmallocStats() const
+{
+    auto ptmalloc = dynamic_cast<const PtmallocAllocator *>(physical_allocator_.get());
+    if (!ptmalloc)
+        return PtmallocAllocator::BinStats{};
+    return ptmalloc->getBinStats();
+}
+
+LifetimeAllocator::LifetimeStats IntegratedMemorySystem::getLifetimeStats() const
+{
+    auto lifetime = dynamic_cast<const LifetimeAllocator *>(physical_allocator_.get());
+    if (!lifetime)
+        return LifetimeAllocator::LifetimeStats{};
+    return lifetime->getLifetimeStats();
+}
+
+IntegratedMemorySystem::MetadataTrafficStats IntegratedMemorySystem::getMetadataTrafficStats() const
+{
+    return {metadata_tracing_, metadata_accesses_, metadata_misses_, metadata_allocations_};
 }
 
 MemoryStats IntegratedMemorySystem::getBuddyAllocatorStats() const
 {
     if (!buddy_allocator_)
         return MemoryStats();
-    return buddy_allocator_->getStats();
+    MemoryStats stats = buddy_allocator_->getStats();
+
+    // Page-cache refills are not requests: the bulk calls behind them are
+    // swapped for the single-page requests the caches served, and free
+    // pages sitting in a cache count as free, as ptmalloc's cached chunks do.
+    auto pcp = getPageCacheStats();
+    Size cached = pcp.cached_pages * nextPowerOfTwo(page_size_);
+    stats.used_memory -= cached;
+    stats.free_memory += cached;
+    stats.allocated_blocks -= pcp.cached_pages;
+    stats.total_blocks -= pcp.cached_pages;
+    stats.allocation_requests = stats.allocation_requests - pcp.pages_requested + pcp.allocations;
+    stats.allocation_successes = stats.allocation_successes - pcp.pages_refilled +
+                                 (pcp.allocations - pcp.allocation_failures);
+    stats.allocation_failures = stats.allocation_failures - (pcp.pages_requested - pcp.pages_refilled) +
+                                pcp.allocation_failures;
+    stats.realloc_moved += page_realloc_moves_.moved;
+    stats.realloc_bytes_copied += page_realloc_moves_.bytes_copied;
+
+    stats.fragmentation_ratio = stats.free_memory > 0
+        ? 1.0 - static_cast<double>(stats.largest_free_block) / stats.free_memory
+        : 0.0;
+    stats.memory_utilization = stats.total_memory > 0
+        ? static_cast<double>(stats.used_memory) / stats.total_memory
+        : 0.0;
+    return stats;
+}
+
+MemoryStats IntegratedMemorySystem::getSlabAllocatorStats() const
+{
+    if (!slab_allocator_)
+        return MemoryStats();
+    MemoryStats stats = slab_allocator_->getStats();
+    stats.realloc_moved = slab_realloc_moves_.moved;
+    stats.realloc_bytes_copied = slab_realloc_moves_.bytes_copied;
+    return stats;
+}
+
+vector<SlabAllocator::CacheInfo> IntegratedMemorySystem::getSlabCacheInfo() const
+{
+    if (!slab_allocator_)
+        return {};
+    return slab_allocator_->getCacheInfo();
 }
 
 VirtualMemoryManager::VMMStats IntegratedMemorySystem::getVMMStats() const
@@ -15,14 +15,19 @@ int main(int argc, char* argv[]) {
             string arg = argv[i];
 
             if (arg == "--memory" && i + 1 < argc) {
-                total_memory = stoul(argv[++i]);
+                total_memory = stoull(argv[++i]);
             } else if (arg == "--page-size" && i + 1 < argc) {
-                page_size = stoul(argv[++i]);
+                page_size = stoull(argv[++i]);
             } else if (arg == "--strategy" && i + 1 < argc) {
                 string strategy = argv[++i];
                 if (strategy == "first") alloc_strategy = AllocationStrategy::FIRST_FIT;
                 else if (strategy == "best") alloc_strategy = AllocationStrategy::BEST_FIT;
                 else if (strategy == "worst") alloc_strategy = AllocationStrategy::WORST_FIT;
+                else if (strategy == "next") alloc_strategy = AllocationStrategy::NEXT_FIT;
+                else if (strategy == "tlsf") alloc_strategy = AllocationStrategy::TLSF;
+                else if (strategy == "bitmap") alloc_strategy = AllocationStrategy::BITMAP;
+                else if (strategy == "ptmalloc") alloc_strategy = AllocationStrategy::PTMALLOC;
+                else if (strategy == "lifetime") alloc_strategy = AllocationStrategy::LIFETIME;
             } else if (arg == "--page-policy" && i + 1 < argc) {
                 string policy = argv[++i];
                 if (policy == "fifo") page_policy = PageReplacementPolicy::FIFO;
@@ -33,7 +38,7 @@ int main(int argc, char* argv[]) {
                 cout << "Usage: " << argv[0] << " [options]\n";
                 cout << "  --memory <size>\n";
                 cout << "  --page-size <size>\n";
-                cout << "  --strategy <first|best|worst>\n";
+                cout << "  --strategy <first|best|worst|next|tlsf|bitmap|ptmalloc|lifetime>\n";
                 cout << "  --page-policy <fifo|lru|clock>\n";
                 return 0;
             }
@@ -0,0 +1,275 @@
+#include "slab/slab_allocator.hpp"
+#include "common/utils.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+namespace
+{
+    // Sizes are spaced so no object wastes more than a third of its slot.
+    const Size SIZE_CLASSES[] = {16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024};
+    constexpr Size CLASS_GRANULE = 16;
+}
+
+SlabAllocator::SlabAllocator(BuddyAllocator &buddy, Size slab_size)
+    : buddy_(buddy),
+      slab_size_(slab_size),
+      allocation_requests_(0),
+      allocation_successes_(0),
+      allocation_failures_(0),
+      internal_fragmentation_(0)
+{
+    if (!isPowerOfTwo(slab_size) || slab_size < MAX_OBJECT_SIZE)
+    {
+        throw invalid_argument("Slab size must be a power of 2 of at least 1 KB");
+    }
+
+    for (Size object_size : SIZE_CLASSES)
+    {
+        Cache cache;
+        cache.object_size = object_size;
+        cache.objects_per_slab = slab_size_ / object_size;
+        cache.active_objects = 0;
+        caches_.push_back(cache);
+    }
+
+    // Size -> cache lookup in 16-byte steps, so picking a class is one load.
+    class_for_units_.resize(MAX_OBJECT_SIZE / CLASS_GRANULE + 1);
+    int cache = 0;
+    for (size_t units = 0; units < class_for_units_.size(); ++units)
+    {
+        while (caches_[cache].object_size < units * CLASS_GRANULE)
+        {
+            cache++;
+        }
+        class_for_units_[units] = cache;
+    }
+}
+
+void SlabAllocator::initialize()
+{
+    for (auto &cache : caches_)
+    {
+        cache.full.clear();
+        cache.partial.clear();
+        cache.empty.clear();
+        cache.active_objects = 0;
+    }
+    slabs_.clear();
+    objects_.clear();
+    internal_fragmentation_ = 0;
+}
+
+AllocationResult SlabAllocator::allocate(const AllocationRequest &request)
+{
+    allocation_requests_++;
+    if (!handles(request.size))
+    {
+        allocation_failures_++;
+        return AllocationResult(false, 0, -1);
+    }
+
+    int index = class_for_units_[(request.size + CLASS_GRANULE - 1) / CLASS_GRANULE];
+    Cache &cache = caches_[index];
+
+    // Partial slabs first so objects stay packed; then a cached empty slab.
+    if (cache.partial.empty() && cache.empty.empty() && !grow(index))
+    {
+        allocation_failures_++;
+        return AllocationResult(false, 0, -1);
+    }
+
+    Address base = !cache.partial.empty() ? cache.partial.front() : cache.empty.front();
+    Slab &slab = slabs_.at(base);
+
+    uint32_t object = slab.free_objects.back();
+    slab.free_objects.pop_back();
+    slab.in_use++;
+    cache.active_objects++;
+
+    moveSlab(base, slab, slab.free_objects.empty() ? SlabState::FULL : SlabState::PARTIAL);
+
+    Address address = base + object * cache.object_size;
+    objects_[address] = make_pair(request.process_id, request.size);
+
+    allocation_successes_++;
+    internal_fragmentation_ += cache.object_size - request.size;
+
+    return AllocationResult(true, address, static_cast<BlockId>(address));
+}
+
+bool SlabAllocator::deallocate(Address address)
+{
+    auto it = objects_.find(address);
+    if (it == objects_.end())
+    {
+        return false;
+    }
+
+    Address base = address - address % slab_size_;
+    Slab &slab = slabs_.at(base);
+    Cache &cache = caches_[slab.cache];
+
+    internal_fragmentation_ -= cache.object_size - it->second.second;
+    objects_.erase(it);
+
+    slab.free_objects.push_back(static_cast<uint32_t>((address - base) / cache.object_size));
+    slab.in_use--;
+    cache.active_objects--;
+
+    if (slab.in_use > 0)
+    {
+        moveSlab(base, slab, SlabState::PARTIAL);
+        return true;
+    }
+
+    // Keep one empty slab per cache so a free/alloc pair at the boundary
+    // does not bounce a page through the buddy allocator.
+    if (cache.empty.empty())
+    {
+        moveSlab(base, slab, SlabState::EMPTY);
+        return true;
+    }
+
+    slabList(cache, slab.state).erase(slab.position);
+    slabs_.erase(base);
+    buddy_.deallocate(base);
+    return true;
+}
+
+Size SlabAllocator::objectSize(Address address) const
+{
+    auto it = objects_.find(address);
+    return it == objects_.end() ? 0 : it->second.second;
+}
+
+size_t SlabAllocator::shrink()
+{
+    // One bulk free, so slabs that sit next to each other merge as a run.
+    vector<Address> bases;
+    for (auto &cache : caches_)
+    {
+        for (Address base : cache.empty)
+        {
+            slabs_.erase(base);
+            bases.push_back(base);
+        }
+        cache.empty.clear();
+    }
+    buddy_.freeBulk(bases);
+    return bases.size();
+}
+
+MemoryStats SlabAllocator::getStats() const
+{
+    MemoryStats stats;
+    stats.total_memory = slabs_.size() * slab_size_;
+
+    Size used = 0;
+    size_t free_objects = 0;
+    for (const auto &cache : caches_)
+    {
+        used += cache.active_objects * cache.object_size;
+        size_t slabs = cache.full.size() + cache.partial.size() + cache.empty.size();
+        free_objects += slabs * cache.objects_per_slab - cache.active_objects;
+    }
+
+    stats.used_memory = used;
+    stats.free_memory = stats.total_memory - used;
+    stats.total_blocks = objects_.size() + free_objects;
+    stats.allocated_blocks = objects_.size();
+    stats.free_blocks = free_objects;
+
+    stats.internal_fragmentation = internal_fragmentation_;
+    stats.allocation_requests = allocation_requests_;
+    stats.allocation_successes = allocation_successes_;
+    stats.allocation_failures = allocation_failures_;
+
+    if (stats.total_memory > 0)
+    {
+        stats.memory_utilization =
+            static_cast<double>(stats.used_memory) / stats.total_memory;
+    }
+
+    return stats;
+}
+
+vector<SlabAllocator::CacheInfo> SlabAllocator::getCacheInfo() const
+{
+    vector<CacheInfo> info;
+    for (const auto &cache : caches_)
+    {
+        info.push_back({cache.object_size,
+                        cache.objects_per_slab,
+                        cache.full.size(),
+                        cache.partial.size(),
+                        cache.empty.size(),
+                        cache.active_objects});
+    }
+    return info;
+}
+
+bool SlabAllocator::grow(int index)
+{
+    Cache &cache = caches_[index];
+    size_t slabs = cache.full.size() + cache.partial.size() + cache.empty.size();
+    size_t count = min(max<size_t>(slabs, 1), GROW_BATCH);
+
+    int order = log2Floor(nextPowerOfTwo(slab_size_));
+    auto bases = buddy_.allocateBulk(order, count, -1);
+    if (bases.empty() && reclaimer_ && reclaimer_() > 0)
+    {
+        bases = buddy_.allocateBulk(order, count, -1);
+    }
+    if (bases.empty())
+    {
+        return false;
+    }
+
+    for (Address base : bases)
+    {
+        Slab &slab = slabs_[base];
+        slab.cache = index;
+        slab.in_use = 0;
+
+        // Stack of free slots with the lowest index on top, so objects fill upward.
+        slab.free_objects.resize(cache.objects_per_slab);
+        for (size_t i = 0; i < cache.objects_per_slab; ++i)
+        {
+            slab.free_objects[i] = static_cast<uint32_t>(cache.objects_per_slab - 1 - i);
+        }
+
+        slab.state = SlabState::EMPTY;
+        slab.position = cache.empty.insert(cache.empty.end(), base);
+    }
+    return true;
+}
+
+void SlabAllocator::moveSlab(Address base, Slab &slab, SlabState state)
+{
+    if (slab.state == state)
+    {
+        return;
+    }
+
+    Cache &cache = caches_[slab.cache];
+    slabList(cache, slab.state).erase(slab.position);
+
+    auto &target = slabList(cache, state);
+    slab.position = target.insert(target.begin(), base);
+    slab.state = state;
+}
+
+list<Address> &SlabAllocator::slabList(Cache &cache, SlabState state)
+{
+    switch (state)
+    {
+    case SlabState::FULL:
+        return cache.full;
+    case SlabState::PARTIAL:
+        return cache.partial;
+    default:
+        return cache.empty;
+    }
+}
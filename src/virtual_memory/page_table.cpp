@@ -4,7 +4,7 @@
 using namespace std;
 
 PageTable::PageTable(ProcessId process_id, Size page_size)
-    : page_size_(page_size), process_id_(process_id) {
+    : page_size_(page_size), process_id_(process_id), present_pages_(0), modified_pages_(0) {
     if (page_size == 0) {
         throw invalid_argument("Page size cannot be zero");
     }
@@ -21,6 +21,7 @@ bool PageTable::addMapping(Address virtual_page, Address physical_frame) {
     entry.process_id = process_id_;
 
     entries_[virtual_page] = entry;
+    present_pages_++;
     return true;
 }
 
@@ -30,6 +31,12 @@ bool PageTable::removeMapping(Address virtual_page) {
         return false;
     }
 
+    if (it->second.present) {
+        present_pages_--;
+        if (it->second.modified) {
+            modified_pages_--;
+        }
+    }
     entries_.erase(it);
     return true;
 }
@@ -57,24 +64,26 @@ void PageTable::setReferenced(Address virtual_page, bool referenced) {
 void PageTable::setModified(Address virtual_page, bool modified) {
     auto it = entries_.find(virtual_page);
     if (it != entries_.end()) {
+        if (it->second.present && it->second.modified != modified) {
+            if (modified) {
+                modified_pages_++;
+            } else {
+                modified_pages_--;
+            }
+        }
         it->second.modified = modified;
     }
 }
 
-size_t PageTable::getPresentPages() const {
-    size_t count = 0;
-    for (const auto& pair : entries_) {
-        if (pair.second.present) {
-            count++;
-        }
-    }
-    return count;
-}
 void PageTable::invalidateFrame(size_t frame_number)
 {
     for (auto& pair : entries_) {
         auto& entry = pair.second;
         if (entry.present && entry.frame_number == frame_number) {
+            present_pages_--;
+            if (entry.modified) {
+                modified_pages_--;
+            }
             entry.present = false;
             entry.referenced = false;
             entry.modified = false;
@@ -82,17 +91,8 @@ void PageTable::invalidateFrame(size_t frame_number)
     }
 }
 
-
-size_t PageTable::getModifiedPages() const {
-    size_t count = 0;
-    for (const auto& pair : entries_) {
-        if (pair.second.present && pair.second.modified) {
-            count++;
-        }
-    }
-    return count;
-}
-
 void PageTable::clear() {
     entries_.clear();
+    present_pages_ = 0;
+    modified_pages_ = 0;
 }
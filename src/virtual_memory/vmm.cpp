@@ -29,6 +29,7 @@ VirtualMemoryManager::VirtualMemoryManager(
 
     num_frames_ = physical_memory_size / page_size;
     frame_allocation_.resize(num_frames_, false);
+    free_frames_ = num_frames_;
 }
 
 bool VirtualMemoryManager::createProcess(ProcessId process_id)
@@ -309,13 +310,7 @@ VirtualMemoryManager::VMMStats VirtualMemoryManager::getStats() const
             ? static_cast<double>(page_faults_) / page_accesses_
             : 0.0;
 
-    stats.free_frames = 0;
-    for (bool allocated : frame_allocation_)
-    {
-        if (!allocated)
-            stats.free_frames++;
-    }
-
+    stats.free_frames = free_frames_;
     stats.total_frames = num_frames_;
     return stats;
 }
@@ -333,11 +328,18 @@ Address VirtualMemoryManager::virtualToPage(Address virtual_address) const
 
 size_t VirtualMemoryManager::allocateFrame()
 {
+    // With every frame taken there is nothing to find; skip the scan.
+    if (free_frames_ == 0)
+    {
+        return static_cast<size_t>(-1);
+    }
+
     for (size_t i = 0; i < num_frames_; ++i)
     {
         if (!frame_allocation_[i])
         {
             frame_allocation_[i] = true;
+            free_frames_--;
             return i;
         }
     }
@@ -346,9 +348,10 @@ size_t VirtualMemoryManager::allocateFrame()
 
 void VirtualMemoryManager::freeFrame(Address frame_number)
 {
-    if (frame_number < num_frames_)
+    if (frame_number < num_frames_ && frame_allocation_[frame_number])
     {
         frame_allocation_[frame_number] = false;
+        free_frames_++;
     }
 }
 